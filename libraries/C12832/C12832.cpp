@@ -16,6 +16,11 @@
 // 25.10.12    add autorefresh of screen
 // 25.10.12    add standart font
 // 20.12.12    add bitmap graphics
+// 17.10.26    send only changed columns of each page
+// 17.10.26    send a page in one transaction
+// 17.10.26    add frames to update the screen once for many drawing calls
+// 17.10.26    add front buffer and render thread
+// 17.10.26    fill by whole bytes of a page
 
 // optional defines :
 // #define debug_lcd  1
@@ -25,15 +30,25 @@
 #include "stdio.h"
 #include "Small_7.h"
 
+//the copy_to_lcd() probe pulls in the Profiler library only when GEOSOL_PROFILE is defined
+#ifdef GEOSOL_PROFILE
+#include "Profiler.h"
+#else
+#define PROFILE_SCOPE(probe)
+#endif
+
 #define BPP    1       // Bits per pixel
 
 
 C12832::C12832(PinName mosi, PinName sck, PinName reset, PinName a0, PinName ncs, const char* name)
-    : _spi(mosi,NC,sck),_reset(reset),_A0(a0),_CS(ncs),GraphicsDisplay(name)
+    : _spi(mosi,NC,sck),_reset(reset),_A0(a0),_CS(ncs),GraphicsDisplay(name),render_ready(0)
 {
     orientation = 1;
     draw_mode = NORMAL;
     char_x = 0;
+    frame_depth = 0;
+    render_thread = NULL;
+    presented = rendered = 0;
     lcd_reset();
 }
 
@@ -53,16 +68,20 @@ int C12832::height()
 
 void C12832::invert(unsigned int o)
 {
+    lock_bus();
     if(o == 0) wr_cmd(0xA6);
     else wr_cmd(0xA7);
+    unlock_bus();
 }
 
 
 void C12832::set_contrast(unsigned int o)
 {
     contrast = o;
+    lock_bus();
     wr_cmd(0x81);      //  set volume
     wr_cmd(o & 0x3F);
+    unlock_bus();
 }
 
 unsigned int C12832::get_contrast(void)
@@ -91,6 +110,31 @@ void C12832::wr_dat(unsigned char dat)
     _CS = 1;
 }
 
+// write a block of data to lcd controller, chip select stays low for all of it
+
+void C12832::wr_data(const uint8_t* data, size_t len)
+{
+    _A0 = 1;
+    _CS = 0;
+    while(len--) {
+        _spi.write(*data++);
+    }
+    _CS = 1;
+}
+
+// once the render thread runs, commands from the caller's thread must not
+// fall between the address and data bytes the thread sends
+
+void C12832::lock_bus(void)
+{
+    if(render_thread) bus_lock.lock();
+}
+
+void C12832::unlock_bus(void)
+{
+    if(render_thread) bus_lock.unlock();
+}
+
 // reset and init the lcd controller
 
 void C12832::lcd_reset()
@@ -127,6 +171,7 @@ void C12832::lcd_reset()
 
     // clear and update LCD
     memset(buffer,0x00,512);  // clear display buffer
+    invalidate();             // controller RAM is undefined after reset
     copy_to_lcd();
     auto_up = 1;              // switch on auto update
     // dont do this by default. Make the user call
@@ -140,7 +185,7 @@ void C12832::lcd_reset()
 void C12832::pixel(int x, int y, int color)
 {
     // first check parameter
-    if(x > 128 || y > 32 || x < 0 || y < 0) return;
+    if(x >= 128 || y >= 32 || x < 0 || y < 0) return;
 
     if(draw_mode == NORMAL) {
         if(color == 0)
@@ -151,60 +196,156 @@ void C12832::pixel(int x, int y, int color)
         if(color == 1)
             buffer[x + ((y/8) * 128)] ^= (1 << (y%8));   // xor pixel
     }
+    mark_dirty(x, x, y/8);
+}
+
+void C12832::mark_dirty(int x0, int x1, int page)
+{
+    if(x0 < dirty_x0[page]) dirty_x0[page] = x0;
+    if(x1 > dirty_x1[page]) dirty_x1[page] = x1;
+}
+
+// shown belongs to the sender, which may be the render thread, so it is left alone:
+// the pages are marked whole in both buffers and sent without comparing them to shown
+
+void C12832::invalidate(void)
+{
+    if(render_thread) front_lock.lock();
+    for(int page=0; page<4; page++) {
+        resend[page] = 1;
+        dirty_x0[page] = 0;
+        dirty_x1[page] = 127;
+        front_x0[page] = 0;
+        front_x1[page] = 127;
+    }
+    if(render_thread) front_lock.unlock();
+}
+
+void C12832::set_address(int x, int page)
+{
+    wr_cmd(0x00 | (x & 0x0F));     // set column low nibble
+    wr_cmd(0x10 | (x >> 4));       // set column hi  nibble
+    wr_cmd(0xB0 | page);           // set page address
+}
+
+// the dirty range is narrowed to the bytes which differ from what the controller already shows,
+// so a redraw with the same text sends nothing. After invalidate() the whole range is taken
+
+int C12832::take_changed(const unsigned char* src, unsigned char* lo, unsigned char* hi, int page, int* x0, int* x1)
+{
+    int a = lo[page], b = hi[page];
+    lo[page] = 128;                // clean
+    hi[page] = 0;
+    if(!resend[page]) {
+        while(a <= b && src[page*128 + a] == shown[page*128 + a]) a++;
+        while(b >= a && src[page*128 + b] == shown[page*128 + b]) b--;
+    }
+    resend[page] = 0;
+    if(a > b) return 0;
+    memcpy(shown + page*128 + a, src + page*128 + a, b - a + 1);
+    *x0 = a;
+    *x1 = b;
+    return 1;
 }
 
 // update lcd
+// with the render thread running, the frame is handed over and sent by the thread
 
 void C12832::copy_to_lcd(void)
 {
+    if(render_thread) present();
+    else send_changes();
+}
+
+// only the changed columns of each page are sent, after a column and page address
+
+void C12832::send_changes(void)
+{
+    PROFILE_SCOPE(GeoSol::PROBE_LCD_COPY);
     
-    int i=0;
+    int page,x0,x1;
     
-    //page 0
-    wr_cmd(0x00);      // set column low nibble 0
-    wr_cmd(0x10);      // set column hi  nibble 0
-    wr_cmd(0xB0);      // set page address  0
-    _A0 = 1;
-    for(i=0; i<128; i++) {
-        wr_dat(buffer[i]);
+    for(page=0; page<4; page++) {
+        if(!take_changed(buffer, dirty_x0, dirty_x1, page, &x0, &x1)) continue;
+        set_address(x0, page);
+        wr_data(shown + page*128 + x0, x1 - x0 + 1);
     }
+}
 
-    // page 1
-    wr_cmd(0x00);      // set column low nibble 0
-    wr_cmd(0x10);      // set column hi  nibble 0
-    wr_cmd(0xB1);      // set page address  1
-    _A0 = 1;
-    for(i=128; i<256; i++) {
-        wr_dat(buffer[i]);
+void C12832::start_render_thread(osPriority priority)
+{
+    if(render_thread) return;
+    memcpy(front, buffer, 512);
+    for(int page=0; page<4; page++) {
+        front_x0[page] = 128;      // clean
+        front_x1[page] = 0;
     }
+    render_thread = new Thread(&C12832::render_loop, this, priority);
+}
 
-    //page 2
-    wr_cmd(0x00);      // set column low nibble 0
-    wr_cmd(0x10);      // set column hi  nibble 0
-    wr_cmd(0xB2);      // set page address  2
-    _A0 = 1;
-    for(i=256; i<384; i++) {
-        wr_dat(buffer[i]);
-    }
+int C12832::rendering(void)
+{
+    return rendered != presented;
+}
 
-    //page 3
-    wr_cmd(0x00);      // set column low nibble 0
-    wr_cmd(0x10);      // set column hi  nibble 0
-    wr_cmd(0xB3);      // set page address  3
-    _A0 = 1;
+// copy the changed columns of the drawing buffer to the front buffer and wake the render thread,
+// the drawing buffer keeps its content because menus redraw only parts of the screen
 
-    _CS = 0;
-    
-    for(i=384; i<512; i++) {
-        wr_dat(buffer[i]);
+void C12832::present(void)
+{
+    int page;
+
+    front_lock.lock();
+    for(page=0; page<4; page++) {
+        if(dirty_x0[page] > dirty_x1[page]) continue;
+        memcpy(front + page*128 + dirty_x0[page], buffer + page*128 + dirty_x0[page], dirty_x1[page] - dirty_x0[page] + 1);
+        if(dirty_x0[page] < front_x0[page]) front_x0[page] = dirty_x0[page];
+        if(dirty_x1[page] > front_x1[page]) front_x1[page] = dirty_x1[page];
+        dirty_x0[page] = 128;      // clean
+        dirty_x1[page] = 0;
     }
+    presented++;
+    front_lock.unlock();
+    render_ready.release();
+}
+
+void C12832::render_loop(void const* lcd)
+{
+    ((C12832*)lcd)->render();
+}
 
+// render thread: takes the changed columns of the front buffer under the lock,
+// then sends them from the copy of the screen, which only this thread writes while it runs
+
+void C12832::render(void)
+{
+    int page,x0[4],x1[4];
+    unsigned int frame;
+
+    while(true) {
+        render_ready.wait();
+        front_lock.lock();
+        frame = presented;
+        for(page=0; page<4; page++) {
+            if(!take_changed(front, front_x0, front_x1, page, &x0[page], &x1[page])) x0[page] = -1;
+        }
+        front_lock.unlock();
+        bus_lock.lock();
+        for(page=0; page<4; page++) {
+            if(x0[page] < 0) continue;
+            set_address(x0[page], page);
+            wr_data(shown + page*128 + x0[page], x1[page] - x0[page] + 1);
+        }
+        bus_lock.unlock();
+        rendered = frame;
+    }
 }
 
 void C12832::cls(void)
 {
     memset(buffer,0x00,512);  // clear display buffer
-    copy_to_lcd();
+    for(int page=0; page<4; page++) mark_dirty(0, 127, page);
+    auto_update();
 }
 
 
@@ -218,22 +359,24 @@ void C12832::line(int x0, int y0, int x1, int y1, int color)
     dx = x1-x0;
     dy = y1-y0;
 
-    //  if (dx == 0) {        /* vertical line */
-    //      if (y1 > y0) vline(x0,y0,y1,color);
-    //      else vline(x0,y1,y0,color);
-    //      return;
-    //  }
+    if (dx == 0) {        /* vertical line */
+        if (y1 > y0) vline(x0,y0,y1,color);
+        else vline(x0,y1,y0,color);
+        auto_update();
+        return;
+    }
 
     if (dx > 0) {
         dx_sym = 1;
     } else {
         dx_sym = -1;
     }
-    //  if (dy == 0) {        /* horizontal line */
-    //      if (x1 > x0) hline(x0,x1,y0,color);
-    //      else  hline(x1,x0,y0,color);
-    //      return;
-    //  }
+    if (dy == 0) {        /* horizontal line */
+        if (x1 > x0) hline(x0,x1,y0,color);
+        else  hline(x1,x0,y0,color);
+        auto_update();
+        return;
+    }
 
     if (dy > 0) {
         dy_sym = 1;
@@ -275,11 +418,12 @@ void C12832::line(int x0, int y0, int x1, int y1, int color)
         }
         pixel(x0, y0, color);
     }
-    if(auto_up) copy_to_lcd();
+    auto_update();
 }
 
 void C12832::rect(int x0, int y0, int x1, int y1, int color)
 {
+    begin_frame();                 // one update for the four sides
 
     if (x1 > x0) line(x0,y0,x1,y0,color);
     else  line(x1,y0,x0,y0,color);
@@ -293,12 +437,12 @@ void C12832::rect(int x0, int y0, int x1, int y1, int color)
     if (y1 > y0) line(x1,y0,x1,y1,color);
     else line(x1,y1,x1,y0,color);
 
-    if(auto_up) copy_to_lcd();
+    end_frame();
 }
 
 void C12832::fillrect(int x0, int y0, int x1, int y1, int color)
 {
-    int l,c,i;
+    int i;
     if(x0 > x1) {
         i = x0;
         x0 = x1;
@@ -311,15 +455,65 @@ void C12832::fillrect(int x0, int y0, int x1, int y1, int color)
         y1 = i;
     }
 
-    for(l = x0; l<= x1; l ++) {
-        for(c = y0; c<= y1; c++) {
-            pixel(l,c,color);
-        }
-    }
-    if(auto_up) copy_to_lcd();
+    span(x0, x1, y0, y1, color);
+    auto_update();
+}
+
+void C12832::hline(int x0, int x1, int y, int color)
+{
+    span(x0, x1, y, y, color);
+}
+
+void C12832::vline(int x, int y0, int y1, int color)
+{
+    span(x, x, y0, y1, color);
+}
+
+void C12832::span(int x0, int x1, int y0, int y1, int color)
+{
+    fill_columns(x0, x1, y0, y1, color);
+    mark_area(x0, x1, y0, y1);
 }
 
+// a page holds 8 lines of each column in one byte, so a rectangle is filled
+// with one mask per page and one byte operation per column
+
+inline void C12832::fill_columns(int x0, int x1, int y0, int y1, int color)
+{
+    int page,last,x;
+    unsigned char mask,*p;
+
+    if(x0 < 0) x0 = 0;
+    if(x1 > 127) x1 = 127;
+    if(y0 < 0) y0 = 0;
+    if(y1 > 31) y1 = 31;
+    if(x0 > x1 || y0 > y1) return;
+    if(draw_mode != NORMAL && color != 1) return;   // xor with 0 changes nothing
+
+    last = y1 >> 3;
+    for(page = y0 >> 3; page <= last; page++) {
+        mask = 0xFF;
+        if(page == y0 >> 3) mask &= 0xFF << (y0 & 7);
+        if(page == last) mask &= 0xFF >> (7 - (y1 & 7));
+        p = buffer + page*128 + x0;
+        if(draw_mode != NORMAL)
+            for(x = x0; x <= x1; x++) *p++ ^= mask;
+        else if(color == 0)
+            for(x = x0; x <= x1; x++) *p++ &= ~mask;
+        else
+            for(x = x0; x <= x1; x++) *p++ |= mask;
+    }
+}
 
+void C12832::mark_area(int x0, int x1, int y0, int y1)
+{
+    if(x0 < 0) x0 = 0;
+    if(x1 > 127) x1 = 127;
+    if(y0 < 0) y0 = 0;
+    if(y1 > 31) y1 = 31;
+    if(x0 > x1 || y0 > y1) return;
+    for(int page = y0 >> 3; page <= y1 >> 3; page++) mark_dirty(x0, x1, page);
+}
 
 void C12832::circle(int x0, int y0, int r, int color)
 {
@@ -426,18 +620,30 @@ void C12832::circle(int x0, int y0, int r, int color)
             pixel(draw_x7, draw_y7, color);
         }
     }
-    if(auto_up) copy_to_lcd();
+    auto_update();
 }
 
+// columns of the same height are filled as one span, each pixel is drawn once.
+// the pages are marked once for the whole circle
+
 void C12832::fillcircle(int x, int y, int r, int color)
 {
-    int i,up;
-    up = auto_up;
-    auto_up = 0;   // off
-    for (i = 0; i <= r; i++)
-        circle(x,y,i,color);
-    auto_up = up;
-    if(auto_up) copy_to_lcd();
+    int dx,h,end;
+
+    if (r < 0) return;
+    h = r;
+    for (dx = 0; dx <= r; dx = end + 1) {
+        // tallest half column inside the circle, same edge as circle()
+        while (h > 0 && dx*dx + h*h > r*r + r) h--;
+        for (end = dx; end < r && (end+1)*(end+1) + h*h <= r*r + r; end++);
+        if (dx == 0) fill_columns(x - end, x + end, y - h, y + h, color);
+        else {
+            fill_columns(x + dx, x + end, y - h, y + h, color);
+            fill_columns(x - end, x - dx, y - h, y + h, color);
+        }
+    }
+    mark_area(x - r, x + r, y - r, y + r);
+    auto_update();
 }
 
 void C12832::setmode(int mode)
@@ -477,7 +683,7 @@ int C12832::_putc(int value)
         }
     } else {
         character(char_x, char_y, value);
-        if(auto_up) copy_to_lcd();
+        auto_update();
     }
     return value;
 }
@@ -540,6 +746,21 @@ unsigned int C12832::get_auto_up(void)
     return (auto_up);
 }
 
+void C12832::begin_frame(void)
+{
+    frame_depth++;
+}
+
+void C12832::end_frame(void)
+{
+    if(frame_depth > 0 && --frame_depth == 0) auto_update();
+}
+
+void C12832::auto_update(void)
+{
+    if(auto_up && frame_depth == 0) copy_to_lcd();
+}
+
 void C12832::print_bm(Bitmap bm, int x, int y)
 {
     int h,v,b;
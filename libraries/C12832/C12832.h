@@ -16,6 +16,7 @@
 #define C12832_H
 
 #include "mbed.h"
+#include "rtos.h"
 #include "GraphicsDisplay.h"
 
 
@@ -132,10 +133,34 @@ public:
 
     /** copy display buffer to lcd
       *
+      * with the render thread started, the changes are copied to the front buffer
+      * and sent by the thread, the call doesn't wait for the display
       */
 
     void copy_to_lcd(void);
 
+    /** start a thread which sends the frames to the lcd
+      *
+      * @param priority of the thread, below the threads which draw and read input
+      *
+      * drawing goes on in the buffer while the thread sends the previous frame
+      * from the front buffer, so the drawing thread never waits for SPI
+      */
+    void start_render_thread(osPriority priority = osPriorityLow);
+
+    /** get status of the render thread
+      *
+      * @returns 1 while a frame handed over by copy_to_lcd() is not on the screen yet
+      */
+    int rendering(void);
+
+    /** mark the whole screen as changed
+      *
+      * the next copy_to_lcd() sends all 512 bytes,
+      * use it when the controller RAM may have lost the picture
+      */
+    void invalidate(void);
+
     /** set the orienation of the screen
       *
       */
@@ -215,6 +240,19 @@ public:
       */
     unsigned int get_auto_up(void);
 
+    /** start a frame
+      *
+      * drawing calls don't update the screen until the matching end_frame(),
+      * frames may be nested, only the outermost end_frame() updates
+      */
+    void begin_frame(void);
+
+    /** end a frame
+      *
+      * sends everything drawn since begin_frame() in one copy_to_lcd() if auto update is on
+      */
+    void end_frame(void);
+
     /** Vars     */
     SPI _spi;
     DigitalOut _reset;
@@ -268,7 +306,7 @@ protected:
      * @param y1 vertical stop
      * @param ,1 set pixel ,0 erase pixel
      */
-    void vline(int y0, int y1, int x, int colour);
+    void vline(int x, int y0, int y1, int colour);
 
     /** Init the C12832 LCD controller
      *
@@ -282,6 +320,14 @@ protected:
      */
     void wr_dat(unsigned char value);
 
+    /** Write a block of data to the LCD controller in one transaction
+     *
+     * @param data bytes written to LCD controller
+     * @param len number of bytes
+     *
+     */
+    void wr_data(const uint8_t* data, size_t len);
+
     /** Write a command the LCD controller
       *
       * @param cmd: command to be written
@@ -291,13 +337,114 @@ protected:
 
     void wr_cnt(unsigned char cmd);
 
+    /** mark columns x0 to x1 of one page as changed
+      *
+      * @param x0,x1 first and last column
+      * @param page page of 8 pixel lines
+      */
+    void mark_dirty(int x0, int x1, int page);
+
+    /** fill a rectangle whole bytes at a time, clipped to the screen
+      *
+      * @param x0,x1 horizontal start and stop, x0 <= x1
+      * @param y0,y1 vertical start and stop, y0 <= y1
+      * @param colour 1 set pixel ,0 erase pixel
+      */
+    void span(int x0, int x1, int y0, int y1, int colour);
+
+    /** fill a rectangle like span() without marking it for the next refresh
+      */
+    void fill_columns(int x0, int x1, int y0, int y1, int colour);
+
+    /** mark a rectangle for the next refresh, clipped to the screen
+      */
+    void mark_area(int x0, int x1, int y0, int y1);
+
+    /** take the columns of one page which have to be sent and mark the page clean
+      *
+      * @param src buffer to take them from, copied to shown
+      * @param lo,hi changed column ranges of src
+      * @param page page of 8 pixel lines
+      * @param x0,x1 receive first and last column
+      * @returns 0 if nothing changed
+      */
+    int take_changed(const unsigned char* src, unsigned char* lo, unsigned char* hi, int page, int* x0, int* x1);
+
+    /** send the changed columns of the buffer to the lcd now
+      */
+    void send_changes(void);
+
+    /** copy the changed columns of the buffer to the front buffer and wake the render thread
+      */
+    void present(void);
+
+    /** loop of the render thread
+      */
+    static void render_loop(void const* lcd);
+    void render(void);
+
+    /** send column and page address
+      */
+    void set_address(int x, int page);
+
+    /** copy display buffer to lcd after a drawing call,
+      * if auto update is on and no frame is open
+      */
+    void auto_update(void);
+
+    /** hold the SPI bus against the render thread, if it runs
+      */
+    void lock_bus(void);
+    void unlock_bus(void);
+
     unsigned int orientation;
     unsigned int char_x;
     unsigned int char_y;
     unsigned char buffer[512];
+    unsigned char shown[512];      // what the controller RAM holds, written by the sender only
+    unsigned char resend[4];       // page sent whole at the next take, set by invalidate()
+    unsigned char dirty_x0[4];     // first changed column of each page, 128 if the page is clean
+    unsigned char dirty_x1[4];     // last changed column of each page
     unsigned int contrast;
     unsigned int auto_up;
+    unsigned int frame_depth;      // begin_frame() calls without end_frame()
+    unsigned char front[512];      // last frame handed to the render thread
+    unsigned char front_x0[4];     // columns of front not taken by the render thread yet
+    unsigned char front_x1[4];
+    Thread* render_thread;
+    Semaphore render_ready;        // released for every frame handed over
+    Mutex front_lock;              // guards front, front_x0, front_x1 and resend
+    Mutex bus_lock;                // held by every SPI sequence while the render thread runs
+    volatile unsigned int presented, rendered;   // frames handed over and sent
+
+};
+
+/** Frame of a C12832 open for the lifetime of the object
+  *
+  * @code
+  * {
+  *     FrameGuard frame(lcd);
+  *     lcd.cls();
+  *     lcd.printf("Hello");
+  * }   // screen updated once here
+  * @endcode
+  */
+class FrameGuard
+{
+public:
+    FrameGuard(C12832& lcd) : _lcd(lcd) {
+        _lcd.begin_frame();
+    }
+
+    ~FrameGuard() {
+        _lcd.end_frame();
+    }
+
+private:
+    FrameGuard(const FrameGuard&);
+    FrameGuard& operator=(const FrameGuard&);
 
+    C12832& _lcd;
 };
 
 
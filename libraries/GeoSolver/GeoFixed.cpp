@@ -0,0 +1,291 @@
+// GeoFixed.cpp
+//integer implementation of short-baseline geodetic problems for targets without double precision hardware
+
+#include "GeoFixed.h"
+#include <stdint.h>
+
+namespace GeoSol {
+
+    //angles are carried as binary angles: full turn is 2^32, so wrap-around is free in int32_t arithmetic
+    //fractions are Q30: 1.0 is 1 << 30
+
+    static const int32_t ONE = 1 << 30;
+    static const int32_t QUARTER_TURN = 1 << 30;
+    static const int CORDIC_STEPS = 30;
+
+    //atan(2^-i) as binary angles
+    static const int32_t CORDIC_ATAN[CORDIC_STEPS] = {
+        536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+        2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+        10430, 5215, 2608, 1304, 652, 326, 163, 81,
+        41, 20, 10, 5, 3, 1
+    };
+
+    //reciprocal of CORDIC gain, Q30
+    static const int32_t CORDIC_K = 652032874;
+
+    //ten millionths of a degree in a half turn
+    static const int64_t HALF_TURN_E7 = 1800000000LL;
+
+    //WGS-84 meridional and prime vertical radii at the equator as Q8 nanometres per ten millionth of a degree
+    static const int64_t K_MERIDIAN = 2830701461LL;
+    static const int64_t K_VERTICAL = 2849778964LL;
+
+    //series of (1 - e^2 sin^2)^(-3/2) and (1 - e^2 sin^2)^(-1/2) in sin^2(lat), Q30
+    static const int32_t M_SERIES[3] = { 10782054, 90224, 705 };
+    static const int32_t N_SERIES[3] = { 3594018, 18045, 101 };
+
+    //micrometres per Q8 nanometre
+    static const int64_t Q8NM_PER_UM = 256000;
+
+    //radians per ten millionth of a degree, Q60
+    static const int64_t RADIANS_PER_E7 = 2012227627LL;
+
+    //differences beyond which a line is longer than MAX_BASELINE anywhere within +-85 degrees of latitude,
+    //ten millionths of a degree: a degree of meridian is at least 110 km, a degree of parallel at 85 degrees 9.7 km.
+    //They keep the mid-latitude series away from differences where they no longer hold
+    static const int32_t MAX_DLAT_E7 = 10000000;
+    static const int32_t MAX_DLON_E7 = 200000000;
+
+    //cap on refinements of the midpoint in direct problem: lines up to 1 km settle in 3 passes,
+    //on longer ones rounding may make the last unit alternate
+    static const int MAX_PASSES = 10;
+
+    //convert ten millionths of a degree to binary angle
+    static int32_t e7ToBinary(int32_t deg) {
+        return (int32_t)(uint32_t)(((int64_t)deg << 32) / (2 * HALF_TURN_E7));
+    }
+
+    //wrap longitude difference in ten millionths of a degree to [-180, 180)
+    static int32_t wrapE7(int64_t deg) {
+        while (deg >= HALF_TURN_E7) deg -= 2 * HALF_TURN_E7;
+        while (deg < -HALF_TURN_E7) deg += 2 * HALF_TURN_E7;
+        return (int32_t)deg;
+    }
+
+    //divide with rounding to nearest
+    static int64_t divRound(int64_t num, int64_t den) {
+        if (den < 0) {
+            num = -num;
+            den = -den;
+        }
+        return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+    }
+
+    //CORDIC in rotation mode: cosine and sine of binary angle, Q30
+    static void cordicSinCos(int32_t ang, int32_t& cosA, int32_t& sinA) {
+        int32_t x = CORDIC_K, y = 0, t;
+        bool flip = false;
+        int i;
+
+        //fold into [-90, 90] degrees, rotation by half turn only changes signs
+        if (ang > QUARTER_TURN || ang < -QUARTER_TURN) {
+            ang = (int32_t)((uint32_t)ang + 0x80000000u);
+            flip = true;
+        }
+
+        for (i = 0; i < CORDIC_STEPS; i++) {
+            t = x;
+            if (ang >= 0) {
+                x -= y >> i;
+                y += t >> i;
+                ang -= CORDIC_ATAN[i];
+            } else {
+                x += y >> i;
+                y -= t >> i;
+                ang += CORDIC_ATAN[i];
+            }
+        }
+
+        cosA = flip ? -x : x;
+        sinA = flip ? -y : y;
+    }
+
+    //CORDIC in vectoring mode: binary angle atan2(y, x) and length of vector (x, y)
+    static int32_t cordicAtan2(int64_t x, int64_t y, int64_t& length) {
+        int32_t ang = 0;
+        int64_t t;
+        int shift = 0, i;
+
+        //turn into right half-plane
+        if (x < 0) {
+            x = -x;
+            y = -y;
+            ang = (int32_t)0x80000000u;
+        }
+
+        //normalize so that iteration keeps full resolution without overflowing 32 bits of growth
+        while (x < ((int64_t)1 << 28) && y < ((int64_t)1 << 28) && y > -((int64_t)1 << 28) && (x | y) != 0) {
+            x <<= 1;
+            y <<= 1;
+            shift++;
+        }
+        while (x >= ((int64_t)1 << 29) || y >= ((int64_t)1 << 29) || y <= -((int64_t)1 << 29)) {
+            x >>= 1;
+            y >>= 1;
+            shift--;
+        }
+
+        for (i = 0; i < CORDIC_STEPS; i++) {
+            t = x;
+            if (y > 0) {
+                x += y >> i;
+                y -= t >> i;
+                ang += CORDIC_ATAN[i];
+            } else {
+                x -= y >> i;
+                y += t >> i;
+                ang -= CORDIC_ATAN[i];
+            }
+        }
+
+        length = (x * CORDIC_K) >> 30;
+        length = shift >= 0 ? length >> shift : length << -shift;
+        return ang;
+    }
+
+    //evaluate 1 + c0 s + c1 s^2 + c2 s^3 for s = sin^2(lat) in Q30
+    static int64_t radiusSeries(const int32_t* c, int64_t s) {
+        int64_t r = c[2];
+        r = c[1] + ((r * s) >> 30);
+        r = c[0] + ((r * s) >> 30);
+        return ONE + ((r * s) >> 30);
+    }
+
+    //multiply by Q30 factor without overflowing for products above 64 bits
+    static int64_t mulQ30(int64_t a, int64_t q) {
+        return (((a >> 15) * q) >> 15) + (((a & 0x7FFF) * q) >> 30);
+    }
+
+    //convert ten millionths of a degree to radians, Q28
+    static int64_t e7ToRadians(int32_t deg) {
+        return ((int64_t)deg * RADIANS_PER_E7) >> 32;
+    }
+
+    //Gauss mid-latitude formulas between points lat1 and lat1 + dLat that are dLon apart
+    //kLat and kLon are Q8 nanometres per ten millionth of a degree along meridian and along parallel,
+    //including the spherical terms of fourth order; returns meridian convergence as binary angle
+    static int32_t midLatitude(int32_t lat1, int32_t dLat, int32_t dLon, int64_t& kLat, int64_t& kLon) {
+        int32_t sinLat, cosLat;
+        int64_t s2, c2, p2, l2, sigma2, rLat, rLon;
+
+        cordicSinCos(e7ToBinary(lat1 + dLat / 2), cosLat, sinLat);
+        s2 = ((int64_t)sinLat * sinLat) >> 30;
+        c2 = ONE - s2;
+        rLat = e7ToRadians(dLat);
+        rLon = e7ToRadians(dLon);
+        p2 = (rLat * rLat) >> 26;
+        l2 = (rLon * rLon) >> 26;
+        sigma2 = p2 + ((l2 * c2) >> 30);
+
+        kLat = mulQ30((K_MERIDIAN * radiusSeries(M_SERIES, s2)) >> 30, ONE + (sigma2 - 3 * l2 - p2) / 24);
+        kLon = mulQ30((((K_VERTICAL * radiusSeries(N_SERIES, s2)) >> 30) * cosLat) >> 30, ONE + (sigma2 - l2) / 24);
+        return (int32_t)mulQ30(((int64_t)e7ToBinary(dLon) * sinLat) >> 30, ONE + (3 * sigma2 - l2 + ((l2 * s2) >> 30)) / 24);
+    }
+
+    //inverse problem in ten millionths of a degree
+    //returns azimuth as binary angle, distance in micrometres
+    static int32_t inverseE7(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2, int64_t& dist) {
+        int32_t dLat = lat2 - lat1;
+        int32_t dLon = wrapE7((int64_t)lon2 - lon1);
+        int32_t convergence;
+        int64_t kLat, kLon;
+
+        convergence = midLatitude(lat1, dLat, dLon, kLat, kLon);
+
+        //atan2 gives azimuth at the midpoint, it exceeds azimuth at the start by half of the convergence
+        return cordicAtan2(divRound((int64_t)dLat * kLat, Q8NM_PER_UM),
+            divRound((int64_t)dLon * kLon, Q8NM_PER_UM), dist) - convergence / 2;
+    }
+
+    //direct problem in ten millionths of a degree, azimuth as binary angle and distance in micrometres
+    static void directE7(int32_t lat1, int32_t lon1, int32_t azimuth, int64_t dist, int32_t& lat2, int32_t& lon2) {
+        int32_t dLat = 0, dLon = 0, nextLat, nextLon, convergence, cosA, sinA;
+        int64_t kLat, kLon;
+        int i;
+
+        //midpoint is not known in advance, refine it until the result stops changing
+        for (i = 0; i < MAX_PASSES; i++) {
+            convergence = midLatitude(lat1, dLat, dLon, kLat, kLon);
+            cordicSinCos(azimuth + convergence / 2, cosA, sinA);
+            nextLat = (int32_t)divRound(mulQ30(dist, cosA) * Q8NM_PER_UM, kLat);
+            nextLon = (int32_t)divRound(mulQ30(dist, sinA) * Q8NM_PER_UM, kLon);
+            if (nextLat == dLat && nextLon == dLon) break;
+            dLat = nextLat;
+            dLon = nextLon;
+        }
+
+        lat2 = lat1 + dLat;
+        lon2 = wrapE7((int64_t)lon1 + dLon);
+    }
+
+    //compute distance and azimuth between two points given as TinyGPS raw coordinates
+    FixedInverse GeoFixed::inverse(long p1Lat, long p1Lon, long p2Lat, long p2Lon) {
+        return inverseHR(p1Lat * 100, p1Lon * 100, p2Lat * 100, p2Lon * 100);
+    }
+
+    //compute coordinates of point from direct problem, TinyGPS raw coordinates
+    FixedDirect GeoFixed::direct(long p1Lat, long p1Lon, long angle, long dist) {
+        FixedDirect res = directHR(p1Lat * 100, p1Lon * 100, angle, dist);
+
+        res.lat = (long)divRound(res.lat, 100);
+        res.lon = (long)divRound(res.lon, 100);
+        return res;
+    }
+
+    //compute coordinates of point from polar problem, TinyGPS raw coordinates
+    FixedDirect GeoFixed::polar(long p1Lat, long p1Lon, long p2Lat, long p2Lon, long angle, long dist) {
+        FixedInverse ab = inverse(p1Lat, p1Lon, p2Lat, p2Lon);
+        FixedDirect res = direct(p1Lat, p1Lon, angle + ab.azimuth, dist);
+
+        if (!ab.valid) {
+            res.lat = res.lon = 0;
+            res.valid = false;
+        }
+        return res;
+    }
+
+    //compute distance and azimuth between two points given in ten millionths of a degree
+    FixedInverse GeoFixed::inverseHR(int32_t p1Lat, int32_t p1Lon, int32_t p2Lat, int32_t p2Lon) {
+        FixedInverse res = { 0, 0, false };
+        int64_t dist, dLat = (int64_t)p2Lat - p1Lat, dLon = wrapE7((int64_t)p2Lon - p1Lon);
+        int32_t azimuth;
+
+        //mm of a longer line would overflow 32 bits beyond 2147 km, and the series fail long before
+        if (dLat > MAX_DLAT_E7 || dLat < -MAX_DLAT_E7 || dLon > MAX_DLON_E7 || dLon < -MAX_DLON_E7)
+            return res;
+        azimuth = inverseE7(p1Lat, p1Lon, p2Lat, p2Lon, dist);
+        if (dist > (int64_t)MAX_BASELINE * 1000)
+            return res;
+        res.dist = (long)divRound(dist, 1000);
+        res.azimuth = (long)divRound((int64_t)(uint32_t)azimuth * 36000000, (int64_t)1 << 32) % 36000000;
+        res.valid = true;
+        return res;
+    }
+
+    //compute coordinates of point from direct problem in ten millionths of a degree
+    FixedDirect GeoFixed::directHR(int32_t p1Lat, int32_t p1Lon, long angle, long dist) {
+        FixedDirect res = { 0, 0, false };
+        int32_t lat, lon;
+
+        if (dist < 0 || dist > MAX_BASELINE)
+            return res;
+        directE7(p1Lat, p1Lon, e7ToBinary(wrapE7((int64_t)angle * 100)), (int64_t)dist * 1000, lat, lon);
+        res.lat = lat;
+        res.lon = lon;
+        res.valid = true;
+        return res;
+    }
+
+    //compute coordinates of point from polar problem in ten millionths of a degree
+    FixedDirect GeoFixed::polarHR(int32_t p1Lat, int32_t p1Lon, int32_t p2Lat, int32_t p2Lon, long angle, long dist) {
+        FixedInverse ab = inverseHR(p1Lat, p1Lon, p2Lat, p2Lon);
+        FixedDirect res = directHR(p1Lat, p1Lon, angle + ab.azimuth, dist);
+
+        if (!ab.valid) {
+            res.lat = res.lon = 0;
+            res.valid = false;
+        }
+        return res;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+// GeoFixed.h
+
+#ifndef GEOFIXED_H
+#define GEOFIXED_H
+
+#include <stdint.h>
+
+namespace GeoSol
+{
+    //result of fixed-point inverse problem
+    struct FixedInverse
+    {
+        //distance between points, mm
+        long dist;
+
+        //azimuth from first point to second point, hundred thousandths of a degree in range [0, 36000000)
+        long azimuth;
+
+        //false for lines longer than GeoFixed::MAX_BASELINE, dist and azimuth are 0 then
+        bool valid;
+    };
+
+    //result of fixed-point direct and polar problems, hundred thousandths of a degree
+    //or ten millionths of a degree for the HR variants
+    struct FixedDirect
+    {
+        //latitude of desired point
+        long lat;
+
+        //longitude of desired point
+        long lon;
+
+        //false if dist was negative or above GeoFixed::MAX_BASELINE, or for polar problem if line AB was,
+        //lat and lon are 0 then
+        bool valid;
+    };
+
+    //Short-baseline geodesy in integer arithmetic only, driven by raw TinyGPS::get_position() coordinates
+    //(hundred thousandths of a degree). Internally coordinates are kept in ten millionths of a degree,
+    //sines and cosines come from 32-bit CORDIC and radii of curvature from series in sin^2(lat),
+    //so no floating point instruction is executed.
+    //Measured by tools/fixedacc against GeoFuncs for latitudes within +-85 degrees: distance error is below
+    //1.5 mm up to 10 km, rounding to whole mm included, below 5 mm up to 50 km and below 4 cm up to
+    //MAX_BASELINE, azimuth error below 0.00003 degree. Positions of the HR direct problem are within 8 mm
+    //up to 10 km, most of it rounding to 0.0000001 degree, within 1 cm up to 50 km and 6 cm up to MAX_BASELINE.
+    //Results of direct and polar problems are rounded to 0.00001 degree, which is up to 1.1 m on the ground,
+    //the HR variants return 0.0000001 degree. Longer lines are not solved, results are flagged invalid
+    class GeoFixed
+    {
+    public:
+
+        //Longest line solved, mm; the error bound holds up to it and distances in mm stay within 32 bits
+        static const long MAX_BASELINE = 100000000L;
+
+        //Returns distance and azimuth between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon)
+        static FixedInverse inverse(long p1Lat, long p1Lon, long p2Lat, long p2Lon);
+
+        //Returns coordinates of point at azimuth angle and distance dist (mm) from A(p1Lat, p1Lon)
+        static FixedDirect direct(long p1Lat, long p1Lon, long angle, long dist);
+
+        //Returns coordinates of point at angle from direction AB and distance dist (mm) from A(p1Lat, p1Lon)
+        static FixedDirect polar(long p1Lat, long p1Lon, long p2Lat, long p2Lon, long angle, long dist);
+
+        //HR variants take and return coordinates in ten millionths of a degree, as TinyGPS::get_position_hr(),
+        //so survey-grade positions keep their resolution; angles and distances are as above
+
+        //Returns distance and azimuth between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon)
+        static FixedInverse inverseHR(int32_t p1Lat, int32_t p1Lon, int32_t p2Lat, int32_t p2Lon);
+
+        //Returns coordinates of point at azimuth angle and distance dist (mm) from A(p1Lat, p1Lon)
+        static FixedDirect directHR(int32_t p1Lat, int32_t p1Lon, long angle, long dist);
+
+        //Returns coordinates of point at angle from direction AB and distance dist (mm) from A(p1Lat, p1Lon)
+        static FixedDirect polarHR(int32_t p1Lat, int32_t p1Lon, int32_t p2Lat, int32_t p2Lon, long angle, long dist);
+    };
+}
+
+#endif
@@ -2,24 +2,17 @@
 //inplemented mathematical engine to solve several geodetic problems
 
 #include "GeoSolver.h"
+#include "GeoTrig.h"
 #include "math.h"
+#include "float.h"
 using namespace std;
 
 namespace GeoSol {
 
-    int GeoFuncs::R = 6371; //Earth radius 
-    double GeoFuncs::PI = 3.1415927; //PI value
-    double GeoFuncs::f = 1 / 298.257223563; //flattening of ellipsoid
-
-    //convert radians to degrees 
-    double GeoFuncs::rad2deg(double rad) {
-        return rad * 180 / PI;
-    }
-
-    //convert degrees to radians
-    double GeoFuncs::deg2rad(double deg) {
-        return deg * PI / 180;
-    }
+    //constants are initialized in the class, these definitions only give them storage
+    constexpr double GeoFuncs::a; //semi-major axis of ellipsoid
+    constexpr double GeoFuncs::PI; //PI value
+    constexpr double GeoFuncs::f; //flattening of ellipsoid
 
     //compute direct distance on the plane using simple Pythagorean theorem
     double GeoFuncs::directDistance(double x1, double y1, double x2, double y2) {
@@ -42,63 +35,675 @@ namespace GeoSol {
             return 0;
     }
 
-    //compute distance between two points on sphere with radius R using solid geometry rules
+    //number of points for which batch functions keep precomputed trigonometry at once
+    static const size_t BATCH_BLOCK = 16;
+
+    //convergence threshold for change of lambda and sigma between iterations, radians (less than 0.01 mm on the ground)
+    static const double EPS = 1e-12;
+
+    //terms of Vincenty's formulae on the auxiliary sphere
+    struct Sigma {
+        double sinSigma, cosSigma, sigma, sinAlpha, cos2Alpha, cos2SigmaM;
+    };
+
+    //wrap difference in longitude into (-180, 180] degrees
+    static double wrapLongitude(double lon) {
+        lon = fmod(lon, 360.0);
+        if (lon > 180)
+            lon -= 360;
+        else if (lon <= -180)
+            lon += 360;
+        return lon;
+    }
+
+    //compute sine and cosine of reduced latitude (latitude on the auxiliary sphere) from latitude trigonometry
+    //tan(U) = (1 - f) * tan(lat), so no additional tan and atan calls are required
+    static void reducedLatitude(double sinLat, double cosLat, double &sinU, double &cosU) {
+        double k = sqrt(cosLat * cosLat + (1 - GeoFuncs::f) * (1 - GeoFuncs::f) * sinLat * sinLat);
+        sinU = (1 - GeoFuncs::f) * sinLat / k;
+        cosU = cosLat / k;
+    }
+
+    //compute coefficients A and B of Vincenty's series from squared cosine of azimuth of the geodesic at the equator
+    static void seriesCoefficients(double cos2Alpha, double &A, double &B) {
+        double b = GeoFuncs::a * (1 - GeoFuncs::f);
+        double u2 = cos2Alpha * (GeoFuncs::a * GeoFuncs::a - b * b) / (b * b);
+        A = 1 + u2 / 16384 * (4096 + u2 * (-768 + u2 * (320 - 175 * u2)));
+        B = u2 / 1024 * (256 + u2 * (-128 + u2 * (74 - 47 * u2)));
+    }
+
+    //compute correction of arc length on the auxiliary sphere from Vincenty's series
+    static double deltaSigma(double B, double sinSigma, double cosSigma, double cos2SigmaM) {
+        double c2 = cos2SigmaM * cos2SigmaM;
+        return B * sinSigma * (cos2SigmaM + B / 4 * (cosSigma * (-1 + 2 * c2)
+            - B / 6 * cos2SigmaM * (-3 + 4 * sinSigma * sinSigma) * (-3 + 4 * c2)));
+    }
+
+    //evaluate terms on the auxiliary sphere for given lambda and return the next value of lambda, L is difference in longitude
+    static double vincentyStep(double sinU1, double cosU1, double sinU2, double cosU2, double L, double lambda, Sigma &s) {
+        double f = GeoFuncs::f;
+        double sinLambda = sin(lambda), cosLambda = cos(lambda);
+        double x = cosU2 * sinLambda, y = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+        double C;
+        s.sinSigma = sqrt(x * x + y * y);
+        s.cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+        s.sigma = atan2(s.sinSigma, s.cosSigma);
+        s.sinAlpha = s.sinSigma == 0 ? 0 : cosU1 * cosU2 * sinLambda / s.sinSigma;
+        s.cos2Alpha = 1 - s.sinAlpha * s.sinAlpha;
+        //cos2Alpha is zero on the equatorial line, where cos2SigmaM is not used
+        s.cos2SigmaM = s.cos2Alpha == 0 ? 0 : s.cosSigma - 2 * sinU1 * sinU2 / s.cos2Alpha;
+        C = f / 16 * s.cos2Alpha * (4 + f * (4 - 3 * s.cos2Alpha));
+        return L + (1 - C) * f * s.sinAlpha * (s.sigma + C * s.sinSigma * (s.cos2SigmaM + C * s.cosSigma * (2 * s.cos2SigmaM * s.cos2SigmaM - 1)));
+    }
+
+    //evaluate terms on the auxiliary sphere for the geodesic running over the pole (lambda = +-PI)
+    static void meridionalStep(double sinU1, double cosU1, double sinU2, double cosU2, Sigma &s) {
+        s.sinSigma = fabs(cosU1 * sinU2 + sinU1 * cosU2);
+        s.cosSigma = sinU1 * sinU2 - cosU1 * cosU2;
+        s.sigma = atan2(s.sinSigma, s.cosSigma);
+        s.sinAlpha = 0;
+        s.cos2Alpha = 1;
+        s.cos2SigmaM = s.cosSigma - 2 * sinU1 * sinU2;
+    }
+
+    //solve Vincenty's equation for lambda, returns number of iterations spent
+    //iteration stops when change of lambda is below EPS or after MAX_ITERATIONS steps;
+    //near-antipodal points where fixed-point iteration does not converge are solved by bounded bisection and flagged
+    //in antipodal, overPole is set when there is no root either and the terms of the line over the pole are returned
+    static int solveLambda(double sinU1, double cosU1, double sinU2, double cosU2, double L, double &lambda, Sigma &s,
+        bool &antipodal, bool &overPole) {
+        double PI = GeoFuncs::PI;
+        double next, lo, hi, mid, hLo, hHi, hMid;
+        int i, k;
+
+        antipodal = overPole = false;
+        lambda = L; //starting value for lambda
+        for (i = 1; i <= GeoFuncs::MAX_ITERATIONS; i++) {
+            next = vincentyStep(sinU1, cosU1, sinU2, cosU2, L, lambda, s);
+            if (fabs(next - lambda) < EPS) {
+                lambda = next;
+                break;
+            }
+            lambda = next;
+        }
+        if (i <= GeoFuncs::MAX_ITERATIONS && fabs(lambda) <= PI)
+            return i;
+        if (i > GeoFuncs::MAX_ITERATIONS)
+            i = GeoFuncs::MAX_ITERATIONS;
+        antipodal = true;
+
+        //lambda differs from L by less than PI * f, so the root of step(lambda) - lambda lies in this interval
+        lo = L - PI * GeoFuncs::f;
+        hi = L + PI * GeoFuncs::f;
+        if (lo < -PI) lo = -PI;
+        if (hi > PI) hi = PI;
+        hLo = vincentyStep(sinU1, cosU1, sinU2, cosU2, L, lo, s) - lo;
+        hHi = vincentyStep(sinU1, cosU1, sinU2, cosU2, L, hi, s) - hi;
+        i += 2;
+
+        k = 0;
+        if ((hLo < 0) != (hHi < 0)) {
+            for (; k < GeoFuncs::MAX_BISECTIONS && hi - lo >= EPS; k++) {
+                mid = (lo + hi) / 2;
+                hMid = vincentyStep(sinU1, cosU1, sinU2, cosU2, L, mid, s) - mid;
+                if ((hMid < 0) == (hLo < 0)) {
+                    lo = mid;
+                    hLo = hMid;
+                } else
+                    hi = mid;
+            }
+            lambda = (lo + hi) / 2;
+            if (PI - fabs(lambda) >= 1e-9) {
+                vincentyStep(sinU1, cosU1, sinU2, cosU2, L, lambda, s);
+                return i + k;
+            }
+        }
+
+        //no root inside (-PI, PI), the geodesic runs over the pole and the series is evaluated on the meridian
+        lambda = L < 0 ? -PI : PI;
+        meridionalStep(sinU1, cosU1, sinU2, cosU2, s);
+        overPole = true;
+        return i + k;
+    }
+
+    //solve inverse problem on the ellipsoid from reduced latitudes and difference in longitude L in radians
+    //antipodal and overPole are those of solveLambda
+    static InverseResult solveInverse(double sinU1, double cosU1, double sinU2, double cosU2, double L, bool &antipodal,
+        bool &overPole) {
+        InverseResult res;
+        Sigma s;
+        double lambda, sinLambda, cosLambda, A, B, back;
+
+        res.iterations = solveLambda(sinU1, cosU1, sinU2, cosU2, L, lambda, s, antipodal, overPole);
+
+        seriesCoefficients(s.cos2Alpha, A, B);
+        res.dist = GeoFuncs::a * (1 - GeoFuncs::f) * A * (s.sigma - deltaSigma(B, s.sinSigma, s.cosSigma, s.cos2SigmaM));
+
+        if (s.sinAlpha == 0 && fabs(lambda) == GeoFuncs::PI) {
+            //meridional geodesic over the pole
+            sinLambda = 0;
+            cosLambda = -1;
+        } else {
+            sinLambda = sin(lambda);
+            cosLambda = cos(lambda);
+        }
+        res.azimuth = GeoFuncs::rad2deg(atan2(cosU2 * sinLambda, cosU1 * sinU2 - sinU1 * cosU2 * cosLambda));
+        //azimuth at the second point continues the line, back azimuth is turned by 180 degrees
+        back = GeoFuncs::rad2deg(atan2(cosU1 * sinLambda, cosU1 * sinU2 * cosLambda - sinU1 * cosU2));
+        res.backAzimuth = back > 0 ? back - 180 : back + 180;
+        return res;
+    }
+
+    //compute distance between two points on the ellipsoid using Vincenty's formulae
     double GeoFuncs::inverseDistanceGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon) {
-        return acos(sin(deg2rad(p1Lat)) * sin(deg2rad(p2Lat)) + cos(deg2rad(p1Lat)) * cos(deg2rad(p2Lat)) * cos(deg2rad(p1Lon - p2Lon))) * R;
+        return inverse(p1Lat, p1Lon, p2Lat, p2Lon).dist;
     }
 
-    //compute azimuth between two points on sphere using Vincenty's formula 
+    //compute azimuth between two points on the ellipsoid using Vincenty's formulae
     double GeoFuncs::inverseAzimuthGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon) {
-        double U1, U2, L, C, lambda, sintheta, costheta, theta, sinalfa, cos2alfa, cos2theta;
-        U1 = atan((1 - f) * tan(deg2rad(p1Lat))); //reduced latitude (latitude on the auxiliary sphere)
-        U2 = atan((1 - f) * tan(deg2rad(p2Lat))); //reduced latitude (latitude on the auxiliary sphere)
-        L = p2Lon - p1Lon; //difference in longitude
-        lambda = L; //starting value for lambda
+        return inverse(p1Lat, p1Lon, p2Lat, p2Lon).azimuth;
+    }
+
+    static void solveAntipodal(double p1Lat, double p1Lon, double p2Lat, double p2Lon, bool overPole, InverseResult &res);
+
+    //compute distance, azimuth and back azimuth sharing trigonometry of both latitudes and a single Vincenty iteration
+    InverseResult GeoFuncs::inverse(double p1Lat, double p1Lon, double p2Lat, double p2Lon) {
+        double lat1 = deg2rad(p1Lat), lat2 = deg2rad(p2Lat);
+        double sinU1, cosU1, sinU2, cosU2;
+        InverseResult res;
+        bool antipodal, overPole;
+        reducedLatitude(sin(lat1), cos(lat1), sinU1, cosU1);
+        reducedLatitude(sin(lat2), cos(lat2), sinU2, cosU2);
+        res = solveInverse(sinU1, cosU1, sinU2, cosU2, deg2rad(wrapLongitude(p2Lon - p1Lon)), antipodal, overPole);
+        if (antipodal)
+            solveAntipodal(p1Lat, p1Lon, p2Lat, p2Lon, overPole, res);
+        return res;
+    }
+
+    //sum of c[k] * sin(2 k x) for k = 1..n (n even) by Clenshaw summation from sin(x) and cos(x)
+    static double sinSeries(const double* c, int n, double sinX, double cosX) {
+        double ar = 2 * (cosX - sinX) * (cosX + sinX), y0 = 0, y1 = 0;
+        while (n > 0) {
+            y1 = ar * y0 - y1 + c[n--];
+            y0 = ar * y1 - y0 + c[n--];
+        }
+        return 2 * sinX * cosX * y0;
+    }
+
+    //set up the line: reduced latitude, azimuth at the equator and series in eps = k^2 / (2 (1 + sqrt(1 + k^2)) + k^2),
+    //series are those of Karney (2013) truncated at sixth order, which is far below the resolution of double here
+    GeodesicLine::GeodesicLine(double p1Lat, double p1Lon, double angle) {
+        double lat1 = GeoFuncs::deg2rad(p1Lat), alpha1 = GeoFuncs::deg2rad(angle);
+        double f = GeoFuncs::f, b = GeoFuncs::a * (1 - f);
+        double cos2Alpha, k2, eps, eps2, d, norm, A1m1, C1[ORDER + 1];
+
+        _lon1 = p1Lon;
+        _sinAlpha1 = sin(alpha1);
+        _cosAlpha1 = cos(alpha1);
+        reducedLatitude(sin(lat1), cos(lat1), _sinU1, _cosU1);
+
+        _sinAlpha0 = _cosU1 * _sinAlpha1;
+        cos2Alpha = 1 - _sinAlpha0 * _sinAlpha0;
+        _C = f / 16 * cos2Alpha * (4 + f * (4 - 3 * cos2Alpha));
+
+        //arc from the equator to the start point
+        norm = sqrt(_sinU1 * _sinU1 + _cosU1 * _cosU1 * _cosAlpha1 * _cosAlpha1);
+        _sinSigma1 = _sinU1 / norm;
+        _cosSigma1 = _cosU1 * _cosAlpha1 / norm;
+
+        k2 = cos2Alpha * (GeoFuncs::a * GeoFuncs::a - b * b) / (b * b);
+        eps = k2 / (2 * (1 + sqrt(1 + k2)) + k2);
+        eps2 = eps * eps;
+        A1m1 = (eps + eps2 * (eps2 * (eps2 + 4) + 64) / 256) / (1 - eps);
+        _bA1 = b * (1 + A1m1);
+
+        d = eps;
+        C1[1] = d * ((6 - eps2) * eps2 - 16) / 32;
+        _C1p[1] = d * ((205 * eps2 - 432) * eps2 + 768) / 1536;
+        d *= eps;
+        C1[2] = d * ((64 - 9 * eps2) * eps2 - 128) / 2048;
+        _C1p[2] = d * ((4005 * eps2 - 4736) * eps2 + 3840) / 12288;
+        d *= eps;
+        C1[3] = d * (9 * eps2 - 16) / 768;
+        _C1p[3] = d * (116 - 225 * eps2) / 384;
+        d *= eps;
+        C1[4] = d * (3 * eps2 - 5) / 512;
+        _C1p[4] = d * (2695 - 7173 * eps2) / 7680;
+        d *= eps;
+        C1[5] = -7 * d / 1280;
+        _C1p[5] = 3467 * d / 7680;
+        d *= eps;
+        C1[6] = -7 * d / 2048;
+        _C1p[6] = 38081 * d / 61440;
+
+        _cosAlpha0 = norm;
+
+        //tau1 = sigma1 + B11, kept as sine and cosine
+        _B11 = sinSeries(C1, ORDER, _sinSigma1, _cosSigma1);
+        _sinTau1 = _sinSigma1 * cos(_B11) + _cosSigma1 * sin(_B11);
+        _cosTau1 = _cosSigma1 * cos(_B11) - _sinSigma1 * sin(_B11);
+    }
+
+    //compute point at distance dist along the line and azimuth of the line there
+    DirectResult GeodesicLine::position(double dist, double* azimuth) const {
+        DirectResult res;
+        double f = GeoFuncs::f;
+        double tau = dist / _bA1, sinTau = sin(tau), cosTau = cos(tau);
+        double delta, delta2, sinDelta, cosDelta, sinSigma, cosSigma, sigma, sinSigma2, cosSigma2, cos2SigmaM, x, lambda;
+
+        //sigma = tau + delta, delta stays below 0.002 so its sine and cosine are short series
+        delta = sinSeries(_C1p, ORDER, _sinTau1 * cosTau + _cosTau1 * sinTau, _cosTau1 * cosTau - _sinTau1 * sinTau) + _B11;
+        delta2 = delta * delta;
+        sinDelta = delta * (1 - delta2 / 6 * (1 - delta2 / 20));
+        cosDelta = 1 - delta2 / 2 * (1 - delta2 / 12);
+        sinSigma = sinTau * cosDelta + cosTau * sinDelta;
+        cosSigma = cosTau * cosDelta - sinTau * sinDelta;
+        sigma = tau + delta;
+
+        //arc from the equator to the point, 2 sigmaM = sigma1 + sigma2
+        sinSigma2 = _sinSigma1 * cosSigma + _cosSigma1 * sinSigma;
+        cosSigma2 = _cosSigma1 * cosSigma - _sinSigma1 * sinSigma;
+        cos2SigmaM = _cosSigma1 * cosSigma2 - _sinSigma1 * sinSigma2;
+
+        x = _sinU1 * sinSigma - _cosU1 * cosSigma * _cosAlpha1;
+        res.lat = GeoFuncs::rad2deg(atan2(_sinU1 * cosSigma + _cosU1 * sinSigma * _cosAlpha1,
+            (1 - f) * sqrt(_sinAlpha0 * _sinAlpha0 + x * x)));
 
-        //wait while lamda converges to 10^(-8) which is sufficiently enough accuracy for us
-        while (abs(lambda) >= 0.00000001) {
-            sintheta = sqrt(pow(cos(U2) * sin(lambda), 2) + pow(cos(U1) * sin(U2) - sin(U1) * cos(U2) * cos(lambda), 2));
-            costheta = sin(U1) * sin(U2) + cos(U1) * cos(U2) * cos(lambda);
-            theta = atan2(sintheta, costheta);
-            sinalfa = cos(U1) * cos(U2) * sin(lambda) / sin(theta);
-            cos2alfa = 1 - pow(sinalfa, 2);
-            cos2theta = costheta - 2 * sin(U1) * sin(U2) / cos2alfa;
-            C = f / 16 * cos2alfa * (4 + f * (4 - 3 * cos2alfa));
-            lambda = L + (1 - C) * f * sinalfa * (theta + C * sintheta * (cos2theta + C * costheta * (1 * pow(cos2theta, 2) - 1)));
+        lambda = atan2(sinSigma * _sinAlpha1, _cosU1 * cosSigma - _sinU1 * sinSigma * _cosAlpha1);
+        lambda -= (1 - _C) * f * _sinAlpha0 * (sigma + _C * sinSigma * (cos2SigmaM + _C * cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM)));
+        res.lon = wrapLongitude(_lon1 + GeoFuncs::rad2deg(lambda));
+
+        //Clairaut: sine of azimuth times cosine of reduced latitude stays sin(alpha0)
+        if (azimuth)
+            *azimuth = GeoFuncs::rad2deg(atan2(_sinAlpha0, _cosAlpha0 * cosSigma2));
+        return res;
+    }
+
+    //miss of the line at distance dist from point (lat, lon), north and east in radians
+    static void missAt(const GeodesicLine &line, double dist, double lat, double lon, double &n, double &e) {
+        DirectResult p = line.position(dist);
+        n = GeoFuncs::deg2rad(lat - p.lat);
+        e = GeoFuncs::deg2rad(wrapLongitude(lon - p.lon)) * cos(GeoFuncs::deg2rad(lat));
+    }
+
+    //steps of finite differences for azimuth (degrees) and distance (km)
+    static const double NEWTON_ANGLE = 1e-6;
+    static const double NEWTON_DIST = 1e-3;
+
+    //near-antipodal points where Vincenty's iteration does not converge: the root found by bisection is poorly
+    //conditioned and on the equator there is none, res then holds the line over the pole, which ends on the antimeridian
+    //of the first point. GeodesicLine is shot from the first point and its azimuth and length are corrected by Newton's
+    //method on the miss at the second point, starting from res. On the equator the shortest line leaves at an angle:
+    //a line which returns to the equator after half a lap has lambda = PI - (1 - C) f PI sin(alpha), which gives the
+    //first azimuth, and lines leaving to the north and to the south are tried
+    static void solveAntipodal(double p1Lat, double p1Lon, double p2Lat, double p2Lon, bool overPole, InverseResult &res) {
+        double L = GeoFuncs::deg2rad(wrapLongitude(p2Lon - p1Lon));
+        double sinAlpha = (GeoFuncs::PI - fabs(L)) / (GeoFuncs::f * GeoFuncs::PI);
+        double start = res.dist, angle, dist, n, e, nA, eA, nS, eS, det, back;
+        bool found = false;
+        int side, k;
+
+        if (sinAlpha > 1)
+            sinAlpha = 1;
+        for (side = 1; side >= (overPole ? -1 : 1); side -= 2) {
+            if (overPole)
+                angle = GeoFuncs::rad2deg(atan2(L < 0 ? -sinAlpha : sinAlpha, side * sqrt(1 - sinAlpha * sinAlpha)));
+            else
+                angle = res.azimuth;
+            dist = start;
+            for (k = 0; k < GeoFuncs::MAX_ITERATIONS; k++) {
+                GeodesicLine line(p1Lat, p1Lon, angle);
+                missAt(line, dist, p2Lat, p2Lon, n, e);
+                if (n * n + e * e < EPS * EPS) {
+                    //on the equator both lines are equally long, the northern one is kept
+                    if (!found || dist < res.dist * (1 - EPS)) {
+                        res.dist = dist;
+                        res.azimuth = wrapLongitude(angle);
+                        line.position(dist, &back);
+                        res.backAzimuth = back > 0 ? back - 180 : back + 180;
+                    }
+                    found = true;
+                    break;
+                }
+                missAt(GeodesicLine(p1Lat, p1Lon, angle + NEWTON_ANGLE), dist, p2Lat, p2Lon, nA, eA);
+                missAt(line, dist + NEWTON_DIST, p2Lat, p2Lon, nS, eS);
+                nA = (nA - n) / NEWTON_ANGLE;
+                eA = (eA - e) / NEWTON_ANGLE;
+                nS = (nS - n) / NEWTON_DIST;
+                eS = (eS - e) / NEWTON_DIST;
+                det = nA * eS - nS * eA;
+                angle -= (eS * n - nS * e) / det;
+                dist -= (nA * e - eA * n) / det;
+            }
+            res.iterations += k;
         }
+    }
 
-        //and then use this lambda in formula 
-        return rad2deg(atan2(cos(U2) * sin(lambda), (cos(U1) * sin(U2) - sin(U1) * cos(U2) * cos(lambda))));
+    //compute coordinates of point on the ellipsoid from direct problem
+    DirectResult GeoFuncs::direct(double p1Lat, double p1Lon, double angle, double dist) {
+        return GeodesicLine(p1Lat, p1Lon, angle).position(dist);
     }
 
-    //compute latitude of point on sphere from direct problem using solid geometry rules 
+    //compute latitude of point on the ellipsoid from direct problem
     double GeoFuncs::directLatGP(double p1Lat, double p1Lon, double angle, double dist) {
-        double relDist, relp1Lat;
-        relDist = dist / R;
-        relp1Lat = deg2rad(p1Lat);
-        angle = deg2rad(angle);
-        return rad2deg(asin(sin(relp1Lat) * cos(relDist) + cos(relp1Lat) * sin(relDist) * cos(angle)));
+        return direct(p1Lat, p1Lon, angle, dist).lat;
     }
 
-    //compute longitude of point on sphere from direct problem using solid geometry rules
+    //compute longitude of point on the ellipsoid from direct problem
     double GeoFuncs::directLonGP(double p1Lat, double p1Lon, double angle, double dist) {
-        double relDist, relp1Lat;
-        relDist = dist / R;
-        relp1Lat = deg2rad(p1Lat);
-        angle = deg2rad(angle);
-        return p1Lon + rad2deg(atan2(sin(angle) * sin(relDist) * cos(relp1Lat),
-            cos(relDist) - sin(relp1Lat) * sin(relp1Lat) * cos(relDist) + cos(relp1Lat) * sin(relDist) * cos(angle)));
+        return direct(p1Lat, p1Lon, angle, dist).lon;
+    }
+
+    //compute coordinates of point on the ellipsoid from polar problem, azimuth to the second point is iterated only once
+    DirectResult GeoFuncs::polar(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist) {
+        angle += inverse(p1Lat, p1Lon, p2Lat, p2Lon).azimuth;
+        return direct(p1Lat, p1Lon, angle, dist);
     }
 
-    //compute latitude of point on sphere from polar problem using solid geometry rules 
+    //compute latitude of point on the ellipsoid from polar problem
     double GeoFuncs::polarLatGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist) {
-        angle += inverseAzimuthGP(p1Lat, p1Lon, p2Lat, p2Lon);
-        return directLatGP(p1Lat, p1Lon, angle, dist);
+        return polar(p1Lat, p1Lon, p2Lat, p2Lon, angle, dist).lat;
     }
 
-    //compute longitude of point on sphere from polar problem using solid geometry rules 
+    //compute longitude of point on the ellipsoid from polar problem
     double GeoFuncs::polarLonGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist) {
-        angle += inverseAzimuthGP(p1Lat, p1Lon, p2Lat, p2Lon);
-        return directLonGP(p1Lat, p1Lon, angle, dist);
+        return polar(p1Lat, p1Lon, p2Lat, p2Lon, angle, dist).lon;
+    }
+
+    //rotate angle with sine s and cosine c by small d, sine and cosine of d from series (|d| < MAX_STEP)
+    static inline void rotateSmall(double &s, double &c, double d) {
+        double d2 = d * d;
+        double sinD = d * (1 - d2 / 6 * (1 - d2 / 20 * (1 - d2 / 42)));
+        double cosD = 1 - d2 / 2 * (1 - d2 / 12 * (1 - d2 / 30));
+        double t = s * cosD + c * sinD;
+        c = c * cosD - s * sinD;
+        s = t;
+    }
+
+    //atan of small t by series (|t| < MAX_STEP)
+    static inline double atanSmall(double t) {
+        double t2 = t * t;
+        return t * (1 - t2 * (1.0 / 3 - t2 * (1.0 / 5 - t2 * (1.0 / 7 - t2 / 9))));
     }
+
+    //longest change of lambda or sigma within one step of the batch iteration, the series above stay exact to
+    //double precision up to it. The first step moves lambda by less than PI * f = 0.0105
+    static const double MAX_STEP = 0.02;
+
+    //steps of the batch iteration, away from antipodes Vincenty's iteration converges within 6
+    static const int BATCH_STEPS = 10;
+
+    //cosine of the arc beyond which lines converge slowly and leave the batch iteration after its first step (170 deg)
+    static const double BATCH_FAR = -0.985;
+
+    //solve inverse problem for arrays of point pairs
+    //reduced latitude of the first point is kept while it repeats, as for distances from one base station.
+    //After the first Vincenty step at lambda = L each step moves lambda and sigma by less than MAX_STEP, so their
+    //sines, cosines and sigma itself are carried by series instead of sin, cos and atan2. Every term lives in its
+    //own array, and the step over the block has no library call but sqrt and picks values by selects, so the
+    //compiler can vectorize it (GCC does with -fno-math-errno, which drops the errno check of sqrt); whether every
+    //pair has converged is decided by a separate max reduction. Pairs which did not converge within BATCH_STEPS,
+    //stepped further than MAX_STEP or span more than 170 degrees of arc, which are the near-antipodal ones,
+    //and pairs whose terms went out of range, are solved again by the scalar solver
+    void GeoFuncs::inverseGP(const double* p1Lat, const double* p1Lon, const double* p2Lat, const double* p2Lon,
+        size_t n, double* dist, double* az) {
+        double sinU1[BATCH_BLOCK], cosU1[BATCH_BLOCK], sinU2[BATCH_BLOCK], cosU2[BATCH_BLOCK], L[BATCH_BLOCK];
+        double lambda[BATCH_BLOCK], sinLambda[BATCH_BLOCK], cosLambda[BATCH_BLOCK];
+        double sinSigma[BATCH_BLOCK], cosSigma[BATCH_BLOCK], sigma[BATCH_BLOCK];
+        double sinAlpha[BATCH_BLOCK], cos2Alpha[BATCH_BLOCK], cos2SigmaM[BATCH_BLOCK];
+        double step[BATCH_BLOCK], worst[BATCH_BLOCK], live[BATCH_BLOCK];
+        double lastLat = 0, lastSinU1 = 0, lastCosU1 = 1, lat, x, y, sinS, cosS, C, next, d, A, B, longest;
+        InverseResult res;
+        bool antipodal, overPole;
+        size_t start, count, i;
+        int k;
+
+        for (start = 0; start < n; start += count) {
+            count = n - start < BATCH_BLOCK ? n - start : BATCH_BLOCK;
+
+            //trigonometry pass, terms of the first point are hoisted while it repeats
+            for (i = 0; i < count; i++) {
+                lat = deg2rad(p1Lat[start + i]);
+                if (start + i == 0 || p1Lat[start + i] != lastLat) {
+                    reducedLatitude(sin(lat), cos(lat), lastSinU1, lastCosU1);
+                    lastLat = p1Lat[start + i];
+                }
+                sinU1[i] = lastSinU1;
+                cosU1[i] = lastCosU1;
+                lat = deg2rad(p2Lat[start + i]);
+                reducedLatitude(sin(lat), cos(lat), sinU2[i], cosU2[i]);
+                L[i] = deg2rad(wrapLongitude(p2Lon[start + i] - p1Lon[start + i]));
+                sinLambda[i] = sin(L[i]);
+                cosLambda[i] = cos(L[i]);
+                lambda[i] = L[i];
+
+                //sigma at lambda = L, which the first step finds unchanged
+                x = cosU2[i] * sinLambda[i];
+                y = cosU1[i] * sinU2[i] - sinU1[i] * cosU2[i] * cosLambda[i];
+                sinSigma[i] = sqrt(x * x + y * y);
+                cosSigma[i] = sinU1[i] * sinU2[i] + cosU1[i] * cosU2[i] * cosLambda[i];
+                sigma[i] = atan2(sinSigma[i], cosSigma[i]);
+                worst[i] = cosSigma[i] < BATCH_FAR ? MAX_STEP : 0;
+            }
+
+            //iteration pass, sigma is corrected by atanSmall from the change of its sine and cosine
+            for (k = 0; k < BATCH_STEPS; k++) {
+                for (i = 0; i < count; i++) {
+                    x = cosU2[i] * sinLambda[i];
+                    y = cosU1[i] * sinU2[i] - sinU1[i] * cosU2[i] * cosLambda[i];
+                    sinS = sqrt(x * x + y * y);
+                    cosS = sinU1[i] * sinU2[i] + cosU1[i] * cosU2[i] * cosLambda[i];
+                    d = atanSmall((sinS * cosSigma[i] - cosS * sinSigma[i]) / (cosS * cosSigma[i] + sinS * sinSigma[i]));
+                    sigma[i] += d;
+                    step[i] = fabs(d);
+                    sinSigma[i] = sinS;
+                    cosSigma[i] = cosS;
+                    //DBL_MIN keeps divisors off zero without a select, GCC would turn one into a branch around
+                    //the division. It changes no divisor above 1e-292; coincident points have a zero dividend,
+                    //on the equator cos2SigmaM only meets C = 0 and is zeroed below
+                    sinAlpha[i] = cosU1[i] * cosU2[i] * sinLambda[i] / (sinS + DBL_MIN);
+                    cos2Alpha[i] = 1 - sinAlpha[i] * sinAlpha[i];
+                    cos2SigmaM[i] = cosS - 2 * sinU1[i] * sinU2[i] / (cos2Alpha[i] + DBL_MIN);
+                    C = f / 16 * cos2Alpha[i] * (4 + f * (4 - 3 * cos2Alpha[i]));
+                    next = L[i] + (1 - C) * f * sinAlpha[i] * (sigma[i] + C * sinS * (cos2SigmaM[i] +
+                        C * cosS * (2 * cos2SigmaM[i] * cos2SigmaM[i] - 1)));
+                    d = next - lambda[i];
+                    rotateSmall(sinLambda[i], cosLambda[i], d);
+                    lambda[i] = next;
+                    step[i] = fabs(d) > step[i] ? fabs(d) : step[i];
+                    worst[i] = step[i] > worst[i] ? step[i] : worst[i];
+                    //pairs which left the batch iteration do not hold the block back
+                    live[i] = worst[i] < MAX_STEP ? step[i] : 0;
+                }
+                longest = 0;
+                for (i = 0; i < count; i++)
+                    longest = live[i] > longest ? live[i] : longest;
+                if (longest < EPS)
+                    break;
+            }
+
+            //distance and azimuth of converged pairs, the others go to the scalar solver
+            for (i = 0; i < count; i++) {
+                if (step[i] < EPS && worst[i] < MAX_STEP && fabs(lambda[i]) <= PI) {
+                    seriesCoefficients(cos2Alpha[i], A, B);
+                    x = cos2Alpha[i] == 0 ? 0 : cos2SigmaM[i];
+                    dist[start + i] = a * (1 - f) * A * (sigma[i] - deltaSigma(B, sinSigma[i], cosSigma[i], x));
+                    az[start + i] = rad2deg(atan2(cosU2[i] * sinLambda[i], cosU1[i] * sinU2[i] - sinU1[i] * cosU2[i] * cosLambda[i]));
+                    continue;
+                }
+                res = solveInverse(sinU1[i], cosU1[i], sinU2[i], cosU2[i], L[i], antipodal, overPole);
+                if (antipodal)
+                    solveAntipodal(p1Lat[start + i], p1Lon[start + i], p2Lat[start + i], p2Lon[start + i], overPole, res);
+                dist[start + i] = res.dist;
+                az[start + i] = res.azimuth;
+            }
+        }
+    }
+
+    //solve direct problem for arrays of start points, the line is built again only when start point or azimuth
+    //change, so points staked out along one line cost a GeodesicLine::position each and other batches cost direct()
+    void GeoFuncs::directGP(const double* p1Lat, const double* p1Lon, const double* angle, const double* dist,
+        size_t n, double* p2Lat, double* p2Lon) {
+        DirectResult res;
+        size_t i, j;
+
+        for (i = 0; i < n; i = j) {
+            GeodesicLine line(p1Lat[i], p1Lon[i], angle[i]);
+            for (j = i; j < n && p1Lat[j] == p1Lat[i] && p1Lon[j] == p1Lon[i] && angle[j] == angle[i]; j++) {
+                res = line.position(dist[j]);
+                p2Lat[j] = res.lat;
+                p2Lon[j] = res.lon;
+            }
+        }
+    }
+
+    //math functions in precision T, float versions call single-precision library functions
+    //or GeoTrig lookup tables when GEOSOL_TRIG_TABLES is defined
+    template <typename T> struct GeoMath;
+
+#ifdef GEOSOL_TRIG_TABLES
+    template <> struct GeoMath<float> {
+        static float sin(float x) { return GeoTrig::sin(x); }
+        static float cos(float x) { return GeoTrig::cos(x); }
+        static float sqrt(float x) { return sqrtf(x); }
+        static float atan2(float y, float x) { return GeoTrig::atan2(y, x); }
+    };
+#else
+    template <> struct GeoMath<float> {
+        static float sin(float x) { return sinf(x); }
+        static float cos(float x) { return cosf(x); }
+        static float sqrt(float x) { return sqrtf(x); }
+        static float atan2(float y, float x) { return atan2f(y, x); }
+    };
+#endif
+
+    template <> struct GeoMath<double> {
+        static double sin(double x) { return ::sin(x); }
+        static double cos(double x) { return ::cos(x); }
+        static double sqrt(double x) { return ::sqrt(x); }
+        static double atan2(double y, double x) { return ::atan2(y, x); }
+    };
+
+    //radii of curvature of the ellipsoid at given latitude, meridian (M) and prime vertical (N)
+    template <typename T>
+    static void curvatureRadii(T sinLat, T &M, T &N) {
+        T a = T(GeoFuncs::a), e2 = T(GeoFuncs::f * (2 - GeoFuncs::f));
+        T w2 = 1 - e2 * sinLat * sinLat, w = GeoMath<T>::sqrt(w2);
+        N = a / w;
+        M = a * (1 - e2) / (w2 * w);
+    }
+
+    //solve inverse problem for line from latitude lat1 with differences dLat and dLon, radians
+    //chord between the points is built in earth-centered coordinates of a frame turned to the first meridian,
+    //every difference is taken through sum-to-product identities so that it keeps full relative precision of T
+    template <typename T>
+    static void chordInverse(T lat1, T dLat, T dLon, T &dist, T &azimuth, T &backAzimuth) {
+        typedef GeoMath<T> M;
+        T a = T(GeoFuncs::a), e2 = T(GeoFuncs::f * (2 - GeoFuncs::f));
+        T lat2 = lat1 + dLat, latM = lat1 + dLat / 2;
+        T sin1 = M::sin(lat1), cos1 = M::cos(lat1), sin2 = M::sin(lat2), cos2 = M::cos(lat2);
+        T sinHalf = M::sin(dLat / 2), sinM = M::sin(latM), cosM = M::cos(latM);
+        T dSin = 2 * cosM * sinHalf, dCos = -2 * sinM * sinHalf;
+        T w1 = M::sqrt(1 - e2 * sin1 * sin1), w2 = M::sqrt(1 - e2 * sin2 * sin2);
+        T N1 = a / w1, N2 = a / w2;
+        T dN = a * e2 * dSin * (sin1 + sin2) / ((w1 + w2) * w1 * w2);
+        T r1 = N1 * cos1, r2 = N2 * cos2, dR = dN * (cos1 + cos2) / 2 + (N1 + N2) / 2 * dCos;
+        T sinHalfLon = M::sin(dLon / 2), sinLon = M::sin(dLon), cosLon = M::cos(dLon);
+
+        //chord in earth-centered coordinates
+        T dX = dR * (1 + cosLon) / 2 - (r1 + r2) * sinHalfLon * sinHalfLon;
+        T dY = r2 * sinLon;
+        T dZ = (1 - e2) * (dN * (sin1 + sin2) / 2 + (N1 + N2) / 2 * dSin);
+
+        //chord in east-north-up coordinates of the first and second point
+        T e = dY, n = cos1 * dZ - sin1 * dX, u = cos1 * dX + sin1 * dZ;
+        T eBack = sinLon * dX - cosLon * dY, nBack = sin2 * (cosLon * dX + sinLon * dY) - cos2 * dZ;
+        T h2 = e * e + n * n, c2 = h2 + u * u;
+        T sin2Az = h2 > 0 ? e * e / h2 : 0;
+        T Mm, Nm;
+
+        azimuth = M::atan2(e, n);
+        backAzimuth = M::atan2(eBack, nBack);
+
+        //arc is longer than chord by c^3 / (24 R^2), R is radius of curvature along the line
+        curvatureRadii(sinM, Mm, Nm);
+        T invR = (1 - sin2Az) / Mm + sin2Az / Nm;
+        dist = M::sqrt(c2) * (1 + c2 * invR * invR / 24);
+    }
+
+    template <typename T>
+    const double GeoFuncsT<T>::SHORT_BASELINE = 50;
+
+    //compute distance and azimuths from chord in precision T, long lines are solved by GeoFuncs
+    template <typename T>
+    InverseResult GeoFuncsT<T>::inverse(double p1Lat, double p1Lon, double p2Lat, double p2Lon) {
+        InverseResult res;
+        T rad = T(GeoFuncs::PI / 180);
+        T dist, azimuth, backAzimuth;
+
+        chordInverse(T(p1Lat) * rad, T(p2Lat - p1Lat) * rad, T(wrapLongitude(p2Lon - p1Lon)) * rad, dist, azimuth, backAzimuth);
+        if (dist > SHORT_BASELINE)
+            return GeoFuncs::inverse(p1Lat, p1Lon, p2Lat, p2Lon);
+
+        res.dist = dist;
+        res.azimuth = azimuth / rad;
+        res.backAzimuth = backAzimuth / rad;
+        res.iterations = 0;
+        return res;
+    }
+
+    //compute coordinates of desired point in precision T, long lines are solved by GeoFuncs
+    //mid-latitude formulae give first approximation and one correction step with the chord inverse
+    //removes their error, which grows with cube of distance
+    template <typename T>
+    DirectResult GeoFuncsT<T>::direct(double p1Lat, double p1Lon, double angle, double dist) {
+        typedef GeoMath<T> M;
+        DirectResult res;
+        T rad = T(GeoFuncs::PI / 180);
+        T lat1 = T(p1Lat) * rad, alpha1 = T(wrapLongitude(angle)) * rad, s = T(dist);
+        T dLat = 0, dLon = 0, sinLat, cosLat, Mr, Nr, alpha, dist2, azimuth, backAzimuth, ds, dAz, dn, de;
+        int i;
+
+        if (dist > SHORT_BASELINE)
+            return GeoFuncs::direct(p1Lat, p1Lon, angle, dist);
+
+        //mid-latitude formulae, azimuth turns by dLon * sin(latM) along the line
+        for (i = 0; i < 3; i++) {
+            sinLat = M::sin(lat1 + dLat / 2);
+            cosLat = M::cos(lat1 + dLat / 2);
+            curvatureRadii(sinLat, Mr, Nr);
+            alpha = alpha1 + dLon * sinLat / 2;
+            dLat = s * M::cos(alpha) / Mr;
+            dLon = s * M::sin(alpha) / (Nr * cosLat);
+        }
+
+        //correction step, misclosure of distance and azimuth is turned into north and east shift at the second point
+        chordInverse(lat1, dLat, dLon, dist2, azimuth, backAzimuth);
+        ds = s - dist2;
+        dAz = alpha1 - azimuth;
+        if (dAz > T(GeoFuncs::PI)) dAz -= 2 * T(GeoFuncs::PI);
+        if (dAz < -T(GeoFuncs::PI)) dAz += 2 * T(GeoFuncs::PI);
+        //forward azimuth at the second point is opposite to the back azimuth
+        dn = -ds * M::cos(backAzimuth) + s * dAz * M::sin(backAzimuth);
+        de = -ds * M::sin(backAzimuth) - s * dAz * M::cos(backAzimuth);
+        sinLat = M::sin(lat1 + dLat);
+        cosLat = M::cos(lat1 + dLat);
+        curvatureRadii(sinLat, Mr, Nr);
+        dLat += dn / Mr;
+        dLon += de / (Nr * cosLat);
+
+        res.lat = p1Lat + double(dLat / rad);
+        res.lon = wrapLongitude(p1Lon + double(dLon / rad));
+        return res;
+    }
+
+    //compute coordinates of point from polar problem in precision T
+    template <typename T>
+    DirectResult GeoFuncsT<T>::polar(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist) {
+        angle += inverse(p1Lat, p1Lon, p2Lat, p2Lon).azimuth;
+        return direct(p1Lat, p1Lon, angle, dist);
+    }
+
+    template class GeoFuncsT<float>;
+    template class GeoFuncsT<double>;
 }
\ No newline at end of file
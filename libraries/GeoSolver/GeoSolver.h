@@ -1,25 +1,62 @@
 // GeoSolver.h
 
+#ifndef GEOSOLVER_H
+#define GEOSOLVER_H
+
+#include <stddef.h>
+
 namespace GeoSol
 {
+    //result of inverse geodesic problem, angles in degrees
+    struct InverseResult
+    {
+        //distance between points
+        double dist;
+        
+        //azimuth from first point to second point
+        double azimuth;
+        
+        //azimuth from second point back to first point
+        double backAzimuth;
+        
+        //number of iterations spent by the solver, never exceeds 3 * GeoFuncs::MAX_ITERATIONS + GeoFuncs::MAX_BISECTIONS + 2
+        int iterations;
+    };
+    
+    //result of direct geodesic and polar serif problems, coordinates in degrees
+    struct DirectResult
+    {
+        //latitude of desired point
+        double lat;
+        
+        //longitude of desired point
+        double lon;
+    };
+    
     class GeoFuncs
     {
     public:
             
         //PI value
-        static double PI;
+        static constexpr double PI = 3.14159265358979323846;
         
-        //Earth radius
-        static int R;
+        //Semi-major axis of WGS-84 ellipsoid, km
+        static constexpr double a = 6378.137;
         
         //Flattening of ellipsoid
-        static double f;
+        static constexpr double f = 1 / 298.257223563;
         
-        //Converts degree into radians
-        static double rad2deg(double rad);
+        //Upper bound of iterations for Vincenty's formulae, keeps worst-case solve time deterministic
+        static const int MAX_ITERATIONS = 20;
         
-        //Converts radians into degree
-        static double deg2rad(double deg);
+        //Upper bound of bisection steps for near-antipodal points where Vincenty's iteration does not converge
+        static const int MAX_BISECTIONS = 48;
+        
+        //Converts radians into degree, folded at compile time for constant arguments
+        static constexpr double rad2deg(double rad) { return rad * (180 / PI); }
+        
+        //Converts degree into radians, folded at compile time for constant arguments
+        static constexpr double deg2rad(double deg) { return deg * (PI / 180); }
         
         //Returns direct distance between points A(x1,y1) and B(x2,y2)
         static double directDistance(double x1, double y1, double x2, double y2);
@@ -27,22 +64,112 @@ namespace GeoSol
         //Returns azimuth between points A(x1,y1) and B(x2,y2)
         static double directAngle(double x1, double y1, double x2, double y2);
         
-        //Returns distance between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon)
+        //Returns distance between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon) on the ellipsoid, km
         static double inverseDistanceGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon);
         
         //Returns azimuth between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon)
         static double inverseAzimuthGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon);
         
+        //Returns distance, azimuth and back azimuth between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon) in one pass
+        //Near-antipodal points where Vincenty's iteration does not converge, and points on the equator within
+        //f * 180 degrees of exact antipodes where it has no root at all, are finished by Newton's method on GeodesicLine
+        static InverseResult inverse(double p1Lat, double p1Lon, double p2Lat, double p2Lon);
+        
         //Returns latitude of desired point in result of direct geodesic problem
         static double directLatGP(double p1Lat, double p1Lon, double angle, double dist);
         
         //Returns longitude of desired point in result of direct geodesic problem
         static double directLonGP(double p1Lat, double p1Lon, double angle, double dist);
         
+        //Returns coordinates of desired point in result of direct geodesic problem in one pass, solved by GeodesicLine
+        static DirectResult direct(double p1Lat, double p1Lon, double angle, double dist);
+        
         //Returns latitude of desired point in result of Polar serif problem
         static double polarLatGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist);
         
         //Returns longitude of desired point in result of Polar serif problem
         static double polarLonGP(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist);
+        
+        //Returns coordinates of desired point in result of Polar serif problem in one pass
+        static DirectResult polar(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist);
+        
+        //Batch inverse problem for n pairs A[i](p1Lat[i], p1Lon[i]) and B[i](p2Lat[i], p2Lon[i]) given as arrays,
+        //writes distances into dist[i] and azimuths into az[i]. Pairs are iterated in blocks together, terms of the
+        //first point are computed once while it repeats; near-antipodal pairs are passed to inverse()
+        static void inverseGP(const double* p1Lat, const double* p1Lon, const double* p2Lat, const double* p2Lon,
+            size_t n, double* dist, double* az);
+        
+        //Batch direct geodesic problem for n start points given as arrays,
+        //writes coordinates of desired points into p2Lat[i] and p2Lon[i], one GeodesicLine serves all points
+        //in a row with the same start point and azimuth
+        static void directGP(const double* p1Lat, const double* p1Lon, const double* angle, const double* dist,
+            size_t n, double* p2Lat, double* p2Lon);
+    };
+    
+    //Geodesic leaving point A(p1Lat, p1Lon) at azimuth angle. Everything that depends only on the start point
+    //and azimuth is computed once by the constructor; arc length on the auxiliary sphere is found from distance
+    //by reverted series instead of iteration, so each position costs one sine/cosine pair, two atan2 and a square root
+    class GeodesicLine
+    {
+    public:
+        
+        GeodesicLine(double p1Lat, double p1Lon, double angle);
+        
+        //Returns coordinates of point at distance dist (km) from the start along the line,
+        //azimuth receives the azimuth of the line at that point unless it is null
+        DirectResult position(double dist, double* azimuth = 0) const;
+        
+    private:
+        
+        //number of terms in series of arc length
+        static const int ORDER = 6;
+        
+        double _lon1;
+        
+        //reduced latitude and azimuth at the start
+        double _sinU1, _cosU1, _sinAlpha1, _cosAlpha1;
+        
+        //azimuth at the equator and Vincenty's longitude coefficient
+        double _sinAlpha0, _cosAlpha0, _C;
+        
+        //arc from the equator to the start, on the auxiliary sphere (sigma) and scaled by distance (tau)
+        double _sinSigma1, _cosSigma1, _sinTau1, _cosTau1, _B11;
+        
+        //distance per radian of tau, km
+        double _bA1;
+        
+        //coefficients of series giving sigma from tau
+        double _C1p[ORDER + 1];
     };
-} 
\ No newline at end of file
+    
+    //Short-baseline geodesy kernels computed in precision T, float kernels run on single-precision FPU
+    //Coordinates stay in double and only differences between them are converted to T, the line is found
+    //from local east-north-up differences of the chord, so rounding does not grow with magnitude of coordinates.
+    //For float error is below 1.5e-6 of distance (1.5 cm at 10 km, 1 mm rms), longer lines are passed to GeoFuncs
+    template <typename T>
+    class GeoFuncsT
+    {
+    public:
+        
+        //Longest line solved in precision T, km
+        static const double SHORT_BASELINE;
+        
+        //Returns distance, azimuth and back azimuth between points A(p1Lat, p1Lon) and B(p2Lat, p2Lon)
+        static InverseResult inverse(double p1Lat, double p1Lon, double p2Lat, double p2Lon);
+        
+        //Returns coordinates of desired point in result of direct geodesic problem
+        static DirectResult direct(double p1Lat, double p1Lon, double angle, double dist);
+        
+        //Returns coordinates of desired point in result of Polar serif problem
+        static DirectResult polar(double p1Lat, double p1Lon, double p2Lat, double p2Lon, double angle, double dist);
+    };
+    
+    //Solver used by the firmware, define GEOSOL_SINGLE_PRECISION to use single-precision kernels
+#ifdef GEOSOL_SINGLE_PRECISION
+    typedef GeoFuncsT<float> Solver;
+#else
+    typedef GeoFuncs Solver;
+#endif
+} 
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+// GeoTrig.cpp
+//table-driven trigonometry, tables are computed by constexpr functions during compilation
+
+#include "GeoTrig.h"
+#include "GeoSolver.h"
+#include "math.h"
+
+namespace GeoSol {
+
+    static constexpr double PI = GeoFuncs::PI;
+
+    //compile-time Taylor series of sine, terms are added until they vanish in double precision
+    static constexpr double sinSeries(double x2, double term, int n) {
+        return n > 40 ? 0 : term + sinSeries(x2, -term * x2 / ((2 * n) * (2 * n + 1)), n + 1);
+    }
+
+    //compile-time sine, argument is first reduced to [-PI, PI]
+    static constexpr double constSin(double x) {
+        return x > PI ? constSin(x - 2 * PI) : sinSeries(x * x, x, 1);
+    }
+
+    //compile-time Euler series of arctangent, converges for every x as powers of x^2 / (1 + x^2)
+    static constexpr double atanSeries(double y, double term, int n) {
+        return n > 60 ? 0 : term + atanSeries(y, term * y * (2 * n) / (2 * n + 1), n + 1);
+    }
+
+    //compile-time arctangent for x in [0, 1]
+    static constexpr double constAtan(double x) {
+        return atanSeries(x * x / (1 + x * x), x / (1 + x * x), 1);
+    }
+
+    //list of table indices for pack expansion
+    template <int... I> struct Indices {};
+    template <int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template <int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+    template <int N> struct Table {
+        float v[N];
+    };
+
+    //sine over a full turn plus a quarter, so that cos(x) reads sin(x + PI / 2) from the same table
+    static const int SIN_SIZE = GeoTrig::SIN_STEPS + GeoTrig::SIN_STEPS / 4;
+
+    template <int... I>
+    static constexpr Table<sizeof...(I)> makeSinTable(Indices<I...>) {
+        return Table<sizeof...(I)>{ { float(constSin(I * (2 * PI / GeoTrig::SIN_STEPS)))... } };
+    }
+
+    template <int... I>
+    static constexpr Table<sizeof...(I)> makeAtanTable(Indices<I...>) {
+        return Table<sizeof...(I)>{ { float(constAtan(double(I) / GeoTrig::ATAN_STEPS))... } };
+    }
+
+    static constexpr Table<SIN_SIZE> SIN_TABLE = makeSinTable(MakeIndices<SIN_SIZE>::type());
+    static constexpr Table<GeoTrig::ATAN_STEPS + 1> ATAN_TABLE = makeAtanTable(MakeIndices<GeoTrig::ATAN_STEPS + 1>::type());
+
+    //table step split into a part with short mantissa, whose multiples are exact, and a small remainder
+    static const float STEP_HI = 0.0245361328125f;
+    static const float STEP_LO = float(2 * PI / GeoTrig::SIN_STEPS - 0.0245361328125);
+    static const float INV_STEP = float(GeoTrig::SIN_STEPS / (2 * PI));
+
+    //sin(x0 + d) = sin(x0) cos(d) + cos(x0) sin(d), table gives x0 and short series give functions of d
+    //x must not be negative: near zero the first node is then sin(0) = 0 and small results keep relative precision
+    static float tableSin(float x, int offset) {
+        int i = (int)(x * INV_STEP);
+        float d, d2;
+
+        d = (x - i * STEP_HI) - i * STEP_LO;
+        d2 = d * d;
+        i = (i + offset) & (GeoTrig::SIN_STEPS - 1);
+
+        return SIN_TABLE.v[i] * (1 - d2 * (0.5f - d2 * (1.0f / 24)))
+            + SIN_TABLE.v[i + GeoTrig::SIN_STEPS / 4] * d * (1 - d2 * (1.0f / 6));
+    }
+
+    float GeoTrig::sin(float x) {
+        return x < 0 ? -tableSin(-x, 0) : tableSin(x, 0);
+    }
+
+    float GeoTrig::cos(float x) {
+        return tableSin(x < 0 ? -x : x, SIN_STEPS / 4);
+    }
+
+    //atan(t) = atan(t0) + atan((t - t0) / (1 + t t0)), second term is small enough for two series terms
+    float GeoTrig::atan2(float y, float x) {
+        float ay = y < 0 ? -y : y, ax = x < 0 ? -x : x;
+        float t, t0, u, r;
+        int i;
+
+        if (ax == 0 && ay == 0) {
+            r = 0;
+        } else {
+            //reduce to first octant
+            t = ay > ax ? ax / ay : ay / ax;
+            i = (int)(t * ATAN_STEPS + 0.5f);
+            t0 = (float)i / ATAN_STEPS;
+            u = (t - t0) / (1 + t * t0);
+            r = ATAN_TABLE.v[i] + u * (1 - u * u * (1.0f / 3));
+            if (ay > ax) r = float(PI / 2) - r;
+        }
+
+        //signs are taken from the sign bits as atan2f does, so atan2(-0, -1) is -PI and atan2(0, -0) is PI
+        if (signbit(x)) r = float(PI) - r;
+        return signbit(y) ? -r : r;
+    }
+}
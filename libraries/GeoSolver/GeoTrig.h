@@ -0,0 +1,35 @@
+// GeoTrig.h
+
+#ifndef GEOTRIG_H
+#define GEOTRIG_H
+
+namespace GeoSol
+{
+    //Single-precision trigonometry from lookup tables generated by the compiler and kept in flash.
+    //Between table nodes values are interpolated with angle-addition identities and short series,
+    //so results stay within a few float ulps of sinf, cosf and atan2f. tools/geobench times both: on an x86 host
+    //with glibc, sin and cos run about as fast as sinf and cosf and atan2 in half the time of atan2f;
+    //the gain on the target depends on its libm.
+    //GeoFuncsT<float> uses these functions when GEOSOL_TRIG_TABLES is defined
+    class GeoTrig
+    {
+    public:
+
+        //Table nodes per full turn for sin and cos
+        static const int SIN_STEPS = 256;
+
+        //Table nodes over [0, 1] for atan
+        static const int ATAN_STEPS = 256;
+
+        //Returns sine of angle in radians
+        static float sin(float x);
+
+        //Returns cosine of angle in radians
+        static float cos(float x);
+
+        //Returns angle of vector (x, y) in radians, range [-PI, PI]
+        static float atan2(float y, float x);
+    };
+}
+
+#endif
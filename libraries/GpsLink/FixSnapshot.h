@@ -0,0 +1,100 @@
+// FixSnapshot.h
+//fix published by the GPS thread and read by any other thread without a lock
+
+#ifndef FIXSNAPSHOT_H
+#define FIXSNAPSHOT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef GEOSOL_HOST
+#include <atomic>
+#define SEQLOCK_BARRIER() std::atomic_thread_fence(std::memory_order_seq_cst)
+#else
+#include "mbed.h"
+#define SEQLOCK_BARRIER() __DMB()
+#endif
+
+namespace GeoSol
+{
+    //Everything the menu shows about the last fix, copied out of TinyGPS in one go
+    struct FixSnapshot
+    {
+        double lat, lon;            //degrees
+        unsigned long date;         //ddmmyy
+        unsigned long time;         //hhmmsscc
+        unsigned long hdop;         //100ths
+        unsigned short satellites;  //used for the fix
+        uint32_t stamp;             //us_ticker_read() when published, microseconds
+        bool valid;                 //false until the first fix
+
+        //Milliseconds since publication, now being a reading of the same clock as stamp.
+        //The difference is taken before scaling, so it stays right when the microsecond clock wraps
+        uint32_t age(uint32_t now) const { return (now - stamp) / 1000; }
+    };
+
+    //Sequence lock around a value with one writer. The writer makes the generation odd, stores the value and
+    //makes it even again; a reader copies the value and keeps it only if it saw the same even generation
+    //before and after the copy, retrying otherwise. Readers never block the writer and take no mutex,
+    //a read races a write only while the few words of the value are stored.
+    //A reader spins while a write is in progress, so the writer must not run at lower priority than readers.
+    //T must be trivially copyable
+    template <typename T>
+    class Seqlock
+    {
+    public:
+
+        Seqlock() : _generation(0) {
+            memset(&_value, 0, sizeof(_value));
+        }
+
+        //Writer: replaces the value, must not be called from two threads at once
+        void write(const T& value) {
+            uint32_t g = _generation;
+            _generation = g + 1;
+            SEQLOCK_BARRIER();
+            copy(&_value, &value);
+            SEQLOCK_BARRIER();
+            _generation = g + 2;
+        }
+
+        //Reader: returns a consistent copy of the last written value
+        T read() const {
+            T value;
+            uint32_t before, after;
+            do {
+                while ((before = _generation) & 1)
+                    ;
+                SEQLOCK_BARRIER();
+                copy(&value, &_value);
+                SEQLOCK_BARRIER();
+                after = _generation;
+            } while (before != after);
+            return value;
+        }
+
+        //Number of completed writes, lets a reader skip work when nothing new was published
+        uint32_t generation() const {
+            uint32_t g;
+            while ((g = _generation) & 1)
+                ;
+            return g >> 1;
+        }
+
+    private:
+        //word-wise volatile copy, so the compiler keeps it between the barriers and does not tear words
+        static void copy(void* to, const void* from) {
+            volatile uint32_t* t = (volatile uint32_t*)to;
+            const volatile uint32_t* f = (const volatile uint32_t*)from;
+            for (size_t i = 0; i < sizeof(T) / sizeof(uint32_t); i++)
+                t[i] = f[i];
+        }
+
+        static_assert(sizeof(T) % sizeof(uint32_t) == 0, "value must be a whole number of words");
+
+        volatile uint32_t _generation;
+        T _value;
+    };
+}
+
+#endif
@@ -0,0 +1,251 @@
+// GpsConfig.cpp
+//UBX-CFG and PMTK command sequences
+
+#include "GpsConfig.h"
+#include "UbxDecoder.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace GeoSol {
+
+    static const uint8_t UBX_CLASS_ACK = 0x05;
+    static const uint8_t UBX_ID_ACK = 0x01;
+    static const uint8_t UBX_CLASS_CFG = 0x06;
+    static const uint8_t UBX_ID_CFG_PRT = 0x00;
+    static const uint8_t UBX_ID_CFG_MSG = 0x01;
+    static const uint8_t UBX_ID_CFG_RATE = 0x08;
+    static const uint8_t UBX_CLASS_NMEA = 0xF0;
+
+    //UBX message ids of NMEA sentences in bit order of GpsSentence
+    static const uint8_t UBX_NMEA_IDS[8] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07, 0x08 };
+
+    //PMTK314 field of NMEA sentences in bit order of GpsSentence, -1 if MTK cannot output it
+    static const int PMTK_FIELDS[8] = { 3, 0, 4, 5, 1, 2, -1, 17 };
+    static const int PMTK_FIELD_COUNT = 19;
+
+    //time receivers take to settle at a new baud rate
+    static const int SWITCH_MS = 100;
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        put16(p, (uint16_t)v);
+        put16(p + 2, (uint16_t)(v >> 16));
+    }
+
+    GpsConfig::GpsConfig(GpsTransport& link, int baud) : _link(link), _receiver(GPS_RECEIVER_UNKNOWN), _baud(baud), _rate(0) {}
+
+    bool GpsConfig::configure(int baud, int rateHz, unsigned sentences) {
+        if (baud <= 0 || rateHz <= 0 || rateHz > MAX_RATE_HZ)
+            return false;
+        if (configureUblox(baud, rateHz, sentences))
+            return true;
+        if (_receiver == GPS_RECEIVER_UBLOX)
+            return false;
+        return configureMtk(baud, rateHz, sentences);
+    }
+
+    bool GpsConfig::configureUblox(int baud, int rateHz, unsigned sentences) {
+        uint8_t payload[20];
+        int oldBaud = _baud, i;
+        bool acknowledged = true;
+
+        //step 1: NMEA output, the first acknowledgement tells that a u-blox receiver is listening.
+        //Later refusals, such as a sentence an older receiver lacks, leave the other sentences worth setting
+        for (i = 0; i < 8; i++) {
+            payload[0] = UBX_CLASS_NMEA;
+            payload[1] = UBX_NMEA_IDS[i];
+            payload[2] = sentences & (1u << i) ? 1 : 0;
+            sendUbx(UBX_CLASS_CFG, UBX_ID_CFG_MSG, payload, 3);
+            if (!waitUbxAck(UBX_CLASS_CFG, UBX_ID_CFG_MSG)) {
+                if (_receiver != GPS_RECEIVER_UBLOX)
+                    return false;
+                acknowledged = false;
+            }
+            _receiver = GPS_RECEIVER_UBLOX;
+        }
+
+        //step 2: UART1 8N1 at the new baud rate, NMEA and UBX in and out;
+        //the acknowledgement may come at either rate, so it is not awaited
+        if (baud != _baud) {
+            memset(payload, 0, sizeof(payload));
+            payload[0] = 1;
+            put32(payload + 4, 0x000008D0);
+            put32(payload + 8, (uint32_t)baud);
+            put16(payload + 12, 0x0003);
+            put16(payload + 14, 0x0003);
+            sendUbx(UBX_CLASS_CFG, UBX_ID_CFG_PRT, payload, 20);
+            switchBaud(baud);
+        }
+
+        //step 3: measurement period, one navigation solution per measurement, aligned to GPS time
+        put16(payload, (uint16_t)(1000 / rateHz));
+        put16(payload + 2, 1);
+        put16(payload + 4, 1);
+        sendUbx(UBX_CLASS_CFG, UBX_ID_CFG_RATE, payload, 6);
+        if (!waitUbxAck(UBX_CLASS_CFG, UBX_ID_CFG_RATE)) {
+            //nothing heard at the new rate: fall back to where the receiver answered
+            if (_baud != oldBaud)
+                switchBaud(oldBaud);
+            return false;
+        }
+        _rate = rateHz;
+        return acknowledged;
+    }
+
+    bool GpsConfig::configureMtk(int baud, int rateHz, unsigned sentences) {
+        char body[64];
+        int fields[PMTK_FIELD_COUNT], i, n, oldBaud = _baud;
+
+        //step 1: NMEA output
+        memset(fields, 0, sizeof(fields));
+        for (i = 0; i < 8; i++)
+            if (PMTK_FIELDS[i] >= 0 && (sentences & (1u << i)))
+                fields[PMTK_FIELDS[i]] = 1;
+        n = snprintf(body, sizeof(body), "PMTK314");
+        for (i = 0; i < PMTK_FIELD_COUNT; i++)
+            n += snprintf(body + n, sizeof(body) - n, ",%d", fields[i]);
+        sendPmtk(body);
+        if (!waitPmtkAck(314))
+            return false;
+        _receiver = GPS_RECEIVER_MTK;
+
+        //step 2: baud rate, MTK does not acknowledge it
+        if (baud != _baud) {
+            snprintf(body, sizeof(body), "PMTK251,%d", baud);
+            sendPmtk(body);
+            switchBaud(baud);
+        }
+
+        //step 3: fix interval
+        snprintf(body, sizeof(body), "PMTK220,%d", 1000 / rateHz);
+        sendPmtk(body);
+        if (!waitPmtkAck(220)) {
+            if (_baud != oldBaud)
+                switchBaud(oldBaud);
+            return false;
+        }
+        _rate = rateHz;
+        return true;
+    }
+
+    void GpsConfig::sendUbx(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t len) {
+        uint8_t head[6], tail[2];
+        uint8_t a, b;
+        uint16_t i;
+
+        head[0] = 0xB5;
+        head[1] = 0x62;
+        head[2] = msgClass;
+        head[3] = msgId;
+        put16(head + 4, len);
+        a = b = 0;
+        for (i = 2; i < 6; i++) {
+            a += head[i];
+            b += a;
+        }
+        for (i = 0; i < len; i++) {
+            a += payload[i];
+            b += a;
+        }
+        tail[0] = a;
+        tail[1] = b;
+        _link.write(head, 6);
+        _link.write(payload, len);
+        _link.write(tail, 2);
+    }
+
+    //true on UBX-ACK-ACK, false on UBX-ACK-NAK or timeout
+    bool GpsConfig::waitUbxAck(uint8_t msgClass, uint8_t msgId) {
+        UbxDecoder ubx;
+        UbxMessage msg;
+        uint8_t buf[32];
+        size_t n, used;
+        const uint8_t* p;
+        uint32_t start = _link.millis();
+        int left;
+
+        while ((left = ACK_TIMEOUT_MS - (int)(_link.millis() - start)) > 0 && (n = _link.read(buf, sizeof(buf), left)) > 0) {
+            for (p = buf; n > 0; p += used, n -= used) {
+                used = ubx.encode(p, n, msg);
+                if (msg == UBX_OTHER && ubx.msgClass() == UBX_CLASS_ACK && ubx.length() == 2 &&
+                        ubx.payload()[0] == msgClass && ubx.payload()[1] == msgId)
+                    return ubx.msgId() == UBX_ID_ACK;
+            }
+        }
+        return false;
+    }
+
+    void GpsConfig::sendPmtk(const char* body) {
+        char tail[8];
+        uint8_t sum = 0;
+        const char* p;
+
+        for (p = body; *p; p++)
+            sum ^= (uint8_t)*p;
+        snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+        _link.write((const uint8_t*)"$", 1);
+        _link.write((const uint8_t*)body, strlen(body));
+        _link.write((const uint8_t*)tail, strlen(tail));
+    }
+
+    //checks NMEA line without $ against its checksum
+    static bool nmeaValid(const char* line) {
+        const char* star = strchr(line, '*');
+        unsigned sum = 0, cs;
+
+        if (!star || sscanf(star + 1, "%2X", &cs) != 1)
+            return false;
+        for (; line < star; line++)
+            sum ^= (uint8_t)*line;
+        return sum == cs;
+    }
+
+    //true on $PMTK001,command,3 (success), false on other flags or timeout
+    bool GpsConfig::waitPmtkAck(int command) {
+        char line[32];
+        uint8_t buf[32];
+        size_t n, i, len = 0;
+        int cmd, flag, left;
+        bool inLine = false;
+        uint32_t start = _link.millis();
+
+        while ((left = ACK_TIMEOUT_MS - (int)(_link.millis() - start)) > 0 && (n = _link.read(buf, sizeof(buf), left)) > 0) {
+            for (i = 0; i < n; i++) {
+                char c = (char)buf[i];
+                if (c == '$') {
+                    inLine = true;
+                    len = 0;
+                } else if (inLine && (c == '\r' || c == '\n')) {
+                    inLine = false;
+                    line[len] = 0;
+                    if (nmeaValid(line) && sscanf(line, "PMTK001,%d,%d", &cmd, &flag) == 2 && cmd == command)
+                        return flag == 3;
+                } else if (inLine) {
+                    //longer lines are not acknowledgements
+                    if (len < sizeof(line) - 1)
+                        line[len++] = c;
+                    else
+                        inLine = false;
+                }
+            }
+        }
+        return false;
+    }
+
+    //changes receiver side first, then waits for it to settle and drops what arrived meanwhile
+    void GpsConfig::switchBaud(int baud) {
+        uint8_t buf[32];
+        uint32_t start;
+        int left;
+
+        _link.baud(baud);
+        _baud = baud;
+        start = _link.millis();
+        while ((left = SWITCH_MS - (int)(_link.millis() - start)) > 0 && _link.read(buf, sizeof(buf), left) > 0)
+            ;
+    }
+}
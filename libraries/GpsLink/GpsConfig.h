@@ -0,0 +1,90 @@
+// GpsConfig.h
+//startup configuration of the GPS receiver: baud rate, navigation rate and NMEA output
+
+#ifndef GPSCONFIG_H
+#define GPSCONFIG_H
+
+#include "GpsTransport.h"
+
+namespace GeoSol
+{
+    //receivers that GpsConfig can command
+    enum GpsReceiver
+    {
+        GPS_RECEIVER_UNKNOWN,   //nothing acknowledged, defaults of the receiver are in effect
+        GPS_RECEIVER_UBLOX,     //UBX-CFG messages
+        GPS_RECEIVER_MTK        //PMTK sentences
+    };
+
+    //NMEA sentences that may be left enabled, combine with |
+    enum GpsSentence
+    {
+        GPS_OUT_GGA = 1 << 0,
+        GPS_OUT_GLL = 1 << 1,
+        GPS_OUT_GSA = 1 << 2,
+        GPS_OUT_GSV = 1 << 3,
+        GPS_OUT_RMC = 1 << 4,
+        GPS_OUT_VTG = 1 << 5,
+        GPS_OUT_GST = 1 << 6,   //u-blox only
+        GPS_OUT_ZDA = 1 << 7
+    };
+
+    //Brings the receiver from its power-on defaults to the link GeoSol runs on.
+    //The receiver type is detected by which command set is acknowledged, u-blox first, then MTK.
+    //Order of steps keeps the link from overflowing at any moment:
+    //  1. unused sentences are disabled at the current baud rate, the acknowledgement identifies the receiver
+    //  2. the receiver and then the transport switch baud rate
+    //  3. navigation rate is raised only after an acknowledgement arrives at the new baud rate
+    //If a step is not acknowledged, the link is left in the last state known to work
+    class GpsConfig
+    {
+    public:
+
+        //Longest wait for an acknowledgement, ms
+        static const int ACK_TIMEOUT_MS = 1000;
+
+        //Highest navigation rate accepted, Hz: u-blox 6 and MTK3339 receivers stop at 10
+        static const int MAX_RATE_HZ = 10;
+
+        //Sentences parsed by TinyGPS for the position, fix quality and dilution of precision
+        static const unsigned DEFAULT_SENTENCES = GPS_OUT_RMC | GPS_OUT_GGA | GPS_OUT_GSA;
+
+        //Link starts at baud, the power-on rate of the receiver
+        GpsConfig(GpsTransport& link, int baud);
+
+        //Configures receiver for baud rate, rateHz solutions per second and the given sentences.
+        //Returns true if every output command and the rate command were acknowledged. The baud rate command
+        //is not awaited, as its acknowledgement may come at either rate: the rate acknowledgement arriving
+        //at the new baud rate confirms it. An output command refused after the receiver was identified
+        //does not stop the remaining steps, but the result is false.
+        //Nothing is sent and false is returned when baud is not positive or rateHz is outside 1..MAX_RATE_HZ
+        bool configure(int baud, int rateHz, unsigned sentences = DEFAULT_SENTENCES);
+
+        //Detected receiver
+        GpsReceiver receiver() const { return _receiver; }
+
+        //Baud rate the link runs at
+        int baud() const { return _baud; }
+
+        //Solutions per second acknowledged by the receiver, 0 if unchanged
+        int rate() const { return _rate; }
+
+    private:
+
+        bool configureUblox(int baud, int rateHz, unsigned sentences);
+        bool configureMtk(int baud, int rateHz, unsigned sentences);
+
+        void sendUbx(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t len);
+        bool waitUbxAck(uint8_t msgClass, uint8_t msgId);
+        void sendPmtk(const char* body);
+        bool waitPmtkAck(int command);
+        void switchBaud(int baud);
+
+        GpsTransport& _link;
+        GpsReceiver _receiver;
+        int _baud;
+        int _rate;
+    };
+}
+
+#endif
@@ -0,0 +1,312 @@
+// GpsTransport.cpp
+//polled serial implementation of GpsTransport
+
+#include "GpsTransport.h"
+#include <string.h>
+
+#ifndef GEOSOL_HOST
+#include "us_ticker_api.h"
+#include "PeripheralPins.h"
+#endif
+
+namespace GeoSol {
+
+    BufferTransport::BufferTransport(const uint8_t* data, size_t len, size_t batch, bool lineBatches) : _data(data),
+        _len(len), _offset(0), _batch(batch ? batch : len), _lineBatches(lineBatches), _baud(9600), _clockUs(0),
+        _batches(0), _written(0) {}
+
+    //written bytes are only counted, their content is not kept
+    void BufferTransport::write(const uint8_t*, size_t len) {
+        _written += len;
+        advance(len);
+    }
+
+    size_t BufferTransport::read(uint8_t* buf, size_t len, int timeoutMs) {
+        size_t n = 0;
+
+        if (_offset == _len) {
+            _clockUs += (uint64_t)timeoutMs * 1000;
+            return 0;
+        }
+        while (n < len && n < _batch && _offset < _len) {
+            buf[n++] = _data[_offset++];
+            if (_lineBatches && buf[n - 1] == '\n')
+                break;
+        }
+        _batches++;
+        advance(n);
+        return n;
+    }
+
+    void BufferTransport::baud(int rate) {
+        _baud = rate;
+    }
+
+    uint32_t BufferTransport::millis() {
+        return (uint32_t)(_clockUs / 1000);
+    }
+
+    //8N1: ten bits per byte
+    void BufferTransport::advance(size_t bytes) {
+        _clockUs += (uint64_t)bytes * 10000000 / _baud;
+    }
+}
+
+#ifndef GEOSOL_HOST
+
+namespace GeoSol {
+
+    void SerialTransport::write(const uint8_t* buf, size_t len) {
+        for (size_t i = 0; i < len; i++)
+            _serial.putc(buf[i]);
+    }
+
+    size_t SerialTransport::read(uint8_t* buf, size_t len, int timeoutMs) {
+        uint32_t start = millis();
+        size_t n = 0;
+
+        //poll without sleeping: UART FIFOs hold only a few characters at high baud rates
+        while (n < len) {
+            if (_serial.readable())
+                buf[n++] = _serial.getc();
+            else if (n > 0 || (int)(millis() - start) >= timeoutMs)
+                break;
+        }
+        return n;
+    }
+
+    void SerialTransport::baud(int rate) {
+        //putc returns when the last character enters the shift register, let it leave
+        wait_ms(2);
+        _serial.baud(rate);
+    }
+
+    uint32_t SerialTransport::millis() {
+        return us_ticker_read() / 1000;
+    }
+
+    IrqTransport::IrqTransport(PinName tx, PinName rx) : _serial(tx, rx), _ready(0), _dropped(0) {
+        _serial.attach(this, &IrqTransport::rxIrq, Serial::RxIrq);
+    }
+
+    //interrupt context: empty the UART FIFO into the ring
+    void IrqTransport::rxIrq() {
+        bool wake = false;
+        char c;
+
+        while (_serial.readable()) {
+            c = _serial.getc();
+            if (!_ring.put(c))
+                _dropped++;
+            if (c == '\n')
+                wake = true;
+        }
+        if (wake || _ring.size() >= RING_SIZE / 2)
+            _ready.release();
+    }
+
+    void IrqTransport::write(const uint8_t* buf, size_t len) {
+        for (size_t i = 0; i < len; i++)
+            _serial.putc(buf[i]);
+    }
+
+    size_t IrqTransport::read(uint8_t* buf, size_t len, int timeoutMs) {
+        uint32_t start = millis();
+        size_t n;
+        int left;
+
+        for (;;) {
+            n = _ring.get(buf, len);
+            if (n > 0)
+                return n;
+            left = timeoutMs - (int)(millis() - start);
+            if (left <= 0)
+                return 0;
+            //tokens left over from lines already read only shorten the sleep
+            _ready.wait(left < IDLE_MS ? left : IDLE_MS);
+        }
+    }
+
+    void IrqTransport::baud(int rate) {
+        wait_ms(2);
+        _serial.baud(rate);
+    }
+
+    uint32_t IrqTransport::millis() {
+        return us_ticker_read() / 1000;
+    }
+
+    //receive request of UART3 on DMAMUX
+    static const uint8_t DMAMUX_SOURCE_UART3_RX = 8;
+    static const int DMA_CHANNELS = 16;
+
+    DmaTransport* DmaTransport::_instance = 0;
+
+    DmaTransport::DmaTransport(PinName tx, PinName rx) : _serial(tx, rx), _channel(-1), _ready(0), _wraps(0),
+        _tail(0), _dropped(0), _overruns(0) {
+        if (_instance || pinmap_peripheral(rx, PinMap_UART_RX) != UART_3)
+            error("DmaTransport: one instance, receiving on UART3\n");
+        //an interrupt or DMA request already enabled means another driver owns UART3 and its vector
+        if ((UART3->C2 & (UART_C2_TIE_MASK | UART_C2_TCIE_MASK | UART_C2_RIE_MASK | UART_C2_ILIE_MASK)) ||
+            (UART3->C5 & UART_C5_RDMAS_MASK))
+            error("DmaTransport: UART3 interrupts in use\n");
+        _instance = this;
+        SIM->SCGC6 |= SIM_SCGC6_DMAMUX_MASK;
+        SIM->SCGC7 |= SIM_SCGC7_DMA_MASK;
+        allocateChannel();
+        NVIC_SetVector((IRQn_Type)(DMA0_IRQn + _channel), (uint32_t)&DmaTransport::dmaIrq);
+        NVIC_SetVector(UART3_RX_TX_IRQn, (uint32_t)&DmaTransport::uartIrq);
+        NVIC_EnableIRQ((IRQn_Type)(DMA0_IRQn + _channel));
+        NVIC_EnableIRQ(UART3_RX_TX_IRQn);
+        startReception();
+    }
+
+    //a channel is taken when DMAMUX routes a source to it or its request is enabled,
+    //the search starts from the top to leave the low channels to drivers with fixed ones
+    void DmaTransport::allocateChannel() {
+        uint8_t cfg;
+
+        for (int ch = DMA_CHANNELS - 1; ch >= 0; ch--) {
+            cfg = DMAMUX->CHCFG[ch];
+            if ((cfg & DMAMUX_CHCFG_ENBL_MASK) &&
+                (cfg & DMAMUX_CHCFG_SOURCE_MASK) == DMAMUX_CHCFG_SOURCE(DMAMUX_SOURCE_UART3_RX))
+                error("DmaTransport: UART3 receive request already routed to DMA channel %d\n", ch);
+            if (_channel < 0 && cfg == 0 && !(DMA0->ERQ & (1UL << ch)))
+                _channel = ch;
+        }
+        if (_channel < 0)
+            error("DmaTransport: no free DMA channel\n");
+    }
+
+    void DmaTransport::startReception() {
+        //one byte from the data register per request, destination wraps around the buffer after the major loop
+        DMA0->CERQ = _channel;
+        DMAMUX->CHCFG[_channel] = 0;
+        DMA0->TCD[_channel].SADDR = (uint32_t)&UART3->D;
+        DMA0->TCD[_channel].SOFF = 0;
+        DMA0->TCD[_channel].ATTR = DMA_ATTR_SSIZE(0) | DMA_ATTR_DSIZE(0);
+        DMA0->TCD[_channel].NBYTES_MLNO = 1;
+        DMA0->TCD[_channel].SLAST = 0;
+        DMA0->TCD[_channel].DADDR = (uint32_t)_buf;
+        DMA0->TCD[_channel].DOFF = 1;
+        DMA0->TCD[_channel].CITER_ELINKNO = DMA_CITER_ELINKNO_CITER(BUFFER_SIZE);
+        DMA0->TCD[_channel].BITER_ELINKNO = DMA_BITER_ELINKNO_BITER(BUFFER_SIZE);
+        DMA0->TCD[_channel].DLAST_SGA = -(int32_t)BUFFER_SIZE;
+        DMA0->TCD[_channel].CSR = DMA_CSR_INTMAJOR_MASK | DMA_CSR_INTHALF_MASK;
+        DMAMUX->CHCFG[_channel] = DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(DMAMUX_SOURCE_UART3_RX);
+        DMA0->SERQ = _channel;
+
+        //without the receive FIFO a read of D leaves the character in place, see uartIrq.
+        //The FIFO may only change with the receiver off
+        UART3->C2 &= ~UART_C2_RE_MASK;
+        UART3->PFIFO &= ~UART_PFIFO_RXFE_MASK;
+        UART3->CFIFO |= UART_CFIFO_RXFLUSH_MASK;
+
+        //a full receiver raises a DMA request instead of an interrupt, idle line counts after the stop bit
+        //an overrun interrupts too, it would stop the receiver for good
+        UART3->C1 |= UART_C1_ILT_MASK;
+        UART3->C3 |= UART_C3_ORIE_MASK;
+        UART3->C5 |= UART_C5_RDMAS_MASK;
+        UART3->C2 |= UART_C2_RIE_MASK | UART_C2_ILIE_MASK | UART_C2_RE_MASK;
+    }
+
+    //interrupt context: a half of the buffer is full, count laps at the end of the major loop
+    void DmaTransport::dmaIrq() {
+        DmaTransport* t = _instance;
+
+        DMA0->CINT = t->_channel;
+        if (DMA0->TCD[t->_channel].CSR & DMA_CSR_DONE_MASK) {
+            DMA0->CDNE = t->_channel;
+            t->_wraps++;
+        }
+        t->_ready.release();
+    }
+
+    //interrupt context: the receiver stopped talking or overran, hand over the partial half
+    void DmaTransport::uartIrq() {
+        uint8_t s1 = UART3->S1;
+
+        //while OR is set the receiver stores nothing and DMA gets no more requests. OR clears by reading S1
+        //then D like IDLE does, which also takes the character waiting for DMA: it is lost with the overrun
+        if (s1 & UART_S1_OR_MASK) {
+            (void)UART3->D;
+            _instance->_overruns++;
+            _instance->_ready.release();
+            return;
+        }
+
+        //IDLE clears by reading S1 then D. With RDRF set in that S1 the read of D would clear RDRF too and
+        //the DMA would skip the character: then the DMA read of D finishes the sequence instead.
+        //A character arriving after the S1 read keeps RDRF, as the sequence did not start with it set
+        if (s1 & UART_S1_IDLE_MASK) {
+            if (!(s1 & UART_S1_RDRF_MASK))
+                (void)UART3->D;
+            _instance->_ready.release();
+        }
+    }
+
+    //bytes written by DMA since start
+    uint32_t DmaTransport::head() {
+        uint32_t wraps, citer, done;
+
+        //a lap the interrupt has not counted yet shows as DONE, read until DONE is stable around CITER
+        do {
+            __disable_irq();
+            done = DMA0->TCD[_channel].CSR & DMA_CSR_DONE_MASK;
+            citer = DMA0->TCD[_channel].CITER_ELINKNO & DMA_CITER_ELINKNO_CITER_MASK;
+            wraps = _wraps + (done ? 1 : 0);
+            __enable_irq();
+        } while (done != (DMA0->TCD[_channel].CSR & DMA_CSR_DONE_MASK));
+        return wraps * BUFFER_SIZE + (BUFFER_SIZE - citer);
+    }
+
+    void DmaTransport::write(const uint8_t* buf, size_t len) {
+        for (size_t i = 0; i < len; i++)
+            _serial.putc(buf[i]);
+    }
+
+    size_t DmaTransport::read(uint8_t* buf, size_t len, int timeoutMs) {
+        uint32_t start = millis(), h, n, first;
+        int left;
+
+        for (;;) {
+            h = head();
+            //DMA lapped the reader: the oldest bytes are gone, continue with what is left
+            if (h - _tail > BUFFER_SIZE) {
+                _dropped += h - _tail - BUFFER_SIZE;
+                _tail = h - BUFFER_SIZE;
+            }
+            n = h - _tail;
+            if (n > len)
+                n = len;
+            if (n > 0) {
+                first = BUFFER_SIZE - _tail % BUFFER_SIZE;
+                if (first > n)
+                    first = n;
+                memcpy(buf, _buf + _tail % BUFFER_SIZE, first);
+                memcpy(buf + first, _buf, n - first);
+                //DMA keeps writing during the copy: bytes it reached again are not the ones
+                //counted, drop them at the top of the loop and copy the rest again
+                if (head() - _tail > BUFFER_SIZE)
+                    continue;
+                _tail += n;
+                return n;
+            }
+            left = timeoutMs - (int)(millis() - start);
+            if (left <= 0)
+                return 0;
+            _ready.wait(left);
+        }
+    }
+
+    void DmaTransport::baud(int rate) {
+        wait_ms(2);
+        _serial.baud(rate);
+    }
+
+    uint32_t DmaTransport::millis() {
+        return us_ticker_read() / 1000;
+    }
+}
+
+#endif
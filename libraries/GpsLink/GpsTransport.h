@@ -0,0 +1,173 @@
+// GpsTransport.h
+//byte link to the GPS receiver, so that configuration and parsing do not depend on how bytes travel
+
+#ifndef GPSTRANSPORT_H
+#define GPSTRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef GEOSOL_HOST
+#include "mbed.h"
+#include "rtos.h"
+#include "SpscRing.h"
+#endif
+
+namespace GeoSol
+{
+    //Interface of a serial link to the receiver. Target code uses SerialTransport, IrqTransport or DmaTransport,
+    //host tools implement it with simulated receivers or recorded data
+    class GpsTransport
+    {
+    public:
+        virtual ~GpsTransport() {}
+
+        //Sends len bytes, returns when they are queued for transmission
+        virtual void write(const uint8_t* buf, size_t len) = 0;
+
+        //Receives up to len bytes, waits at most timeoutMs for the first one.
+        //Returns number of bytes received, 0 on timeout
+        virtual size_t read(uint8_t* buf, size_t len, int timeoutMs) = 0;
+
+        //Changes baud rate of the link after queued bytes have been sent
+        virtual void baud(int rate) = 0;
+
+        //Returns milliseconds of a free-running clock, wraps around
+        virtual uint32_t millis() = 0;
+    };
+
+    //GpsTransport serving recorded receiver output from memory, for testing parsers off-target.
+    //Reads come in batches the way DMA hands them over: at most batch bytes, and with lineBatches set
+    //ending after every line as if the line went idle there. Written bytes are counted and dropped,
+    //the clock advances by the transfer time of every byte at the current baud rate
+    class BufferTransport : public GpsTransport
+    {
+    public:
+        BufferTransport(const uint8_t* data, size_t len, size_t batch, bool lineBatches);
+
+        virtual void write(const uint8_t* buf, size_t len);
+        virtual size_t read(uint8_t* buf, size_t len, int timeoutMs);
+        virtual void baud(int rate);
+        virtual uint32_t millis();
+
+        //True when all recorded data has been read
+        bool finished() const { return _offset == _len; }
+
+        //Number of batches handed out and bytes written so far
+        unsigned long batches() const { return _batches; }
+        unsigned long written() const { return _written; }
+
+    private:
+        void advance(size_t bytes);
+
+        const uint8_t* _data;
+        size_t _len, _offset, _batch;
+        bool _lineBatches;
+        int _baud;
+        uint64_t _clockUs;
+        unsigned long _batches, _written;
+    };
+
+#ifndef GEOSOL_HOST
+    //GpsTransport over mbed Serial, polled
+    class SerialTransport : public GpsTransport
+    {
+    public:
+        SerialTransport(Serial& serial) : _serial(serial) {}
+
+        virtual void write(const uint8_t* buf, size_t len);
+        virtual size_t read(uint8_t* buf, size_t len, int timeoutMs);
+        virtual void baud(int rate);
+        virtual uint32_t millis();
+
+    private:
+        Serial& _serial;
+    };
+
+    //GpsTransport over RawSerial driven by the receive interrupt. The handler moves characters from the UART
+    //into a lock-free ring and wakes the reader on every end of line or when the ring is half full, so the
+    //reading thread sleeps on a semaphore instead of polling, and characters keep arriving while other
+    //threads hold the core
+    class IrqTransport : public GpsTransport
+    {
+    public:
+
+        //Bytes buffered between interrupt and reader: 1/10 s of traffic at 115200 baud
+        static const uint32_t RING_SIZE = 1024;
+
+        //Reader checks the ring at least this often while it waits, for data without line ends such as UBX
+        static const int IDLE_MS = 20;
+
+        IrqTransport(PinName tx, PinName rx);
+
+        virtual void write(const uint8_t* buf, size_t len);
+        virtual size_t read(uint8_t* buf, size_t len, int timeoutMs);
+        virtual void baud(int rate);
+        virtual uint32_t millis();
+
+        //Characters lost because the ring was full
+        unsigned long dropped() const { return _dropped; }
+
+    private:
+        void rxIrq();
+
+        RawSerial _serial;
+        SpscRing<RING_SIZE> _ring;
+        Semaphore _ready;
+        volatile unsigned long _dropped;
+    };
+
+    //GpsTransport receiving through eDMA on FRDM-K64F, D1/D0 being UART3.
+    //The UART requests a DMA transfer for every character and the channel writes a circular buffer in place,
+    //raising an interrupt only when either half fills. The UART idle-line interrupt flags the end of
+    //each burst, so a sentence batch reaches the reader as soon as the receiver stops talking,
+    //without any per-character interrupt. Transmission and baud rate go through RawSerial.
+    //The constructor takes the highest DMA channel not routed or enabled by anyone else and the UART3 vector,
+    //and stops with error() when rx is not on UART3, UART3 interrupts or its DMA request are already in use,
+    //or no channel is free. A receiver overrun stops UART3 until it is cleared, the UART interrupt clears it
+    //and counts it in overruns(). Not yet run on hardware, main.cpp uses it only with GEOSOL_DMA_TRANSPORT defined
+    class DmaTransport : public GpsTransport
+    {
+    public:
+
+        //Size of the circular buffer, each half holds 1/20 s of traffic at 115200 baud
+        static const uint32_t BUFFER_SIZE = 1024;
+
+        DmaTransport(PinName tx, PinName rx);
+
+        virtual void write(const uint8_t* buf, size_t len);
+        virtual size_t read(uint8_t* buf, size_t len, int timeoutMs);
+        virtual void baud(int rate);
+        virtual uint32_t millis();
+
+        //Characters overwritten by DMA before they were read
+        unsigned long dropped() const { return _dropped; }
+
+        //Receiver overruns, each loses at least one character
+        unsigned long overruns() const { return _overruns; }
+
+        //DMA channel used for reception
+        int channel() const { return _channel; }
+
+    private:
+        static void dmaIrq();
+        static void uartIrq();
+        void allocateChannel();
+        void startReception();
+        uint32_t head();
+
+        static DmaTransport* _instance;
+
+        RawSerial _serial;
+        int _channel;
+        uint8_t _buf[BUFFER_SIZE];
+        Semaphore _ready;
+        volatile uint32_t _wraps;
+        uint32_t _tail;
+        unsigned long _dropped;
+        volatile unsigned long _overruns;
+    };
+#endif
+}
+
+#endif
@@ -0,0 +1,74 @@
+// SpscRing.h
+//lock-free ring of bytes between one producer, typically an interrupt handler, and one consumer thread
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef GEOSOL_HOST
+#include <atomic>
+#define SPSC_BARRIER() std::atomic_thread_fence(std::memory_order_seq_cst)
+#else
+#include "mbed.h"
+#define SPSC_BARRIER() __DMB()
+#endif
+
+namespace GeoSol
+{
+    //Each index is written by one side only and both run free over 2^32, so their difference is the fill
+    //and no lock or disabled interrupt is needed. The barrier orders the byte store before the index store
+    //for the producer and the index load before the byte loads for the consumer.
+    //Size must be a power of two
+    template <uint32_t N>
+    class SpscRing
+    {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+    public:
+
+        SpscRing() : _head(0), _tail(0) {}
+
+        //Producer: appends c, returns false and drops it when the ring is full
+        bool put(uint8_t c) {
+            uint32_t head = _head;
+            if (head - _tail == N)
+                return false;
+            _buf[head & (N - 1)] = c;
+            SPSC_BARRIER();
+            _head = head + 1;
+            return true;
+        }
+
+        //Consumer: moves up to len bytes to buf, returns their number
+        size_t get(uint8_t* buf, size_t len) {
+            uint32_t tail = _tail, n = _head - tail, first;
+            SPSC_BARRIER();
+            if (n > len)
+                n = (uint32_t)len;
+            //copy in at most two runs, split where the ring wraps
+            first = N - (tail & (N - 1));
+            if (first > n)
+                first = n;
+            memcpy(buf, _buf + (tail & (N - 1)), first);
+            memcpy(buf + first, _buf, n - first);
+            SPSC_BARRIER();
+            _tail = tail + n;
+            return n;
+        }
+
+        //Number of bytes waiting, exact for the consumer, a lower bound of free space for the producer
+        uint32_t size() const { return _head - _tail; }
+
+        static const uint32_t CAPACITY = N;
+
+    private:
+        volatile uint32_t _head;
+        volatile uint32_t _tail;
+        uint8_t _buf[N];
+    };
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Profiler.cpp
+//statistics of cycle-count probes
+
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef GEOSOL_HOST
+#include <chrono>
+#else
+#include "mbed.h"
+#endif
+
+namespace GeoSol {
+
+    static ProfileStats probes[PROBE_COUNT];
+
+    static const char* const names[PROBE_COUNT] = {
+        "updateValue",
+        "GeoFuncs::inverse",
+        "GeoFuncs::direct",
+        "GeoFuncs::polar",
+        "TinyGPS::encode",
+        "C12832::copy_to_lcd"
+    };
+
+    //index of histogram bin: number of significant bits of duration
+    static int bin(uint32_t ticks) {
+        int k = 0;
+        while (ticks) {
+            ticks >>= 1;
+            k++;
+        }
+        return k;
+    }
+
+    void Profiler::init() {
+#ifndef GEOSOL_HOST
+        //trace must be enabled for DWT to count
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+        reset();
+    }
+
+    uint32_t Profiler::now() {
+#ifdef GEOSOL_HOST
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        return DWT->CYCCNT;
+#endif
+    }
+
+    void Profiler::record(int probe, uint32_t ticks) {
+        ProfileStats &st = probes[probe];
+
+        if (st.count == 0 || ticks < st.min)
+            st.min = ticks;
+        if (ticks > st.max)
+            st.max = ticks;
+        st.sum += ticks;
+        st.count++;
+        st.hist[bin(ticks)]++;
+    }
+
+    const ProfileStats& Profiler::stats(int probe) {
+        return probes[probe];
+    }
+
+    const char* Profiler::name(int probe) {
+        return names[probe];
+    }
+
+    void Profiler::reset() {
+        memset(probes, 0, sizeof(probes));
+    }
+
+    void Profiler::dump(ProfileWriter write) {
+        char line[80];
+        int i, k;
+
+        write("probe count min max mean\r\n");
+        for (i = 0; i < PROBE_COUNT; i++) {
+            const ProfileStats &st = probes[i];
+            if (st.count == 0)
+                continue;
+            snprintf(line, sizeof(line), "%s %lu %lu %lu %lu\r\n", names[i], (unsigned long)st.count,
+                (unsigned long)st.min, (unsigned long)st.max, (unsigned long)(st.sum / st.count));
+            write(line);
+            for (k = 0; k < PROFILE_BINS; k++) {
+                if (st.hist[k] == 0)
+                    continue;
+                //bin is labelled with the longest duration it holds
+                snprintf(line, sizeof(line), "  <=%lu %lu\r\n", k < 32 ? (1UL << k) - 1 : 0xFFFFFFFFUL, (unsigned long)st.hist[k]);
+                write(line);
+            }
+        }
+    }
+}
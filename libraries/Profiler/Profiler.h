@@ -0,0 +1,89 @@
+// Profiler.h
+//cycle-count probes for hot paths, compiled in only when GEOSOL_PROFILE is defined
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+namespace GeoSol
+{
+    //probed code paths
+    enum ProfileProbe
+    {
+        PROBE_UPDATE_VALUE,
+        PROBE_INVERSE,
+        PROBE_DIRECT,
+        PROBE_POLAR,
+        PROBE_GPS_ENCODE,
+        PROBE_LCD_COPY,
+        PROBE_COUNT
+    };
+
+    //histogram bins: one per bit length of a 32-bit duration and one for zero
+    static const int PROFILE_BINS = 33;
+
+    //statistics of one probe, durations in ticks: CPU cycles on target, nanoseconds on the host
+    struct ProfileStats
+    {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+
+        //hist[k] counts durations d with 2^(k-1) <= d < 2^k, hist[0] counts zero durations
+        uint32_t hist[PROFILE_BINS];
+    };
+
+    //receives one line of text from Profiler::dump()
+    typedef void (*ProfileWriter)(const char* line);
+
+    //Keeps statistics of probes in RAM. On target ticks come from the DWT cycle counter of Cortex-M4,
+    //with GEOSOL_HOST defined from std::chrono::steady_clock, so probes run unchanged in host builds.
+    //Statistics are updated without locking: a probe hit from two threads at once may lose one sample
+    class Profiler
+    {
+    public:
+
+        //Starts the tick counter, call once before the first probe
+        static void init();
+
+        //Returns current tick count, wraps around
+        static uint32_t now();
+
+        //Adds duration of one run of probe
+        static void record(int probe, uint32_t ticks);
+
+        //Returns statistics of probe
+        static const ProfileStats& stats(int probe);
+
+        //Returns printable name of probe
+        static const char* name(int probe);
+
+        //Clears statistics of all probes
+        static void reset();
+
+        //Prints statistics and non-empty histogram bins of all probes, line by line
+        static void dump(ProfileWriter write);
+    };
+
+    //measures its own lifetime and records it for probe
+    class ProfileScope
+    {
+    public:
+        ProfileScope(int probe) : _probe(probe), _start(Profiler::now()) {}
+        ~ProfileScope() { Profiler::record(_probe, Profiler::now() - _start); }
+
+    private:
+        int _probe;
+        uint32_t _start;
+    };
+}
+
+#ifdef GEOSOL_PROFILE
+#define PROFILE_SCOPE(probe) GeoSol::ProfileScope profileScope(probe)
+#else
+#define PROFILE_SCOPE(probe)
+#endif
+
+#endif
@@ -21,32 +21,110 @@
 */
 
 #include "TinyGPS.h"
+#include <stdint.h>
+#include <string.h>
 
-#define _GPRMC_TERM   "GPRMC"
-#define _GPGGA_TERM   "GPGGA"
-#define _GPGSV_TERM   "GPGSV"
+// probes are compiled in only with GEOSOL_PROFILE, so the library also builds without the Profiler library
+#ifdef GEOSOL_PROFILE
+#include "Profiler.h"
+#else
+#define PROFILE_SCOPE(probe)
+#endif
+
+// sentence formatter packed into one value, the two talker characters before it are ignored
+#define _GPS_FORMATTER(a, b, c) (((unsigned long)(a) << 16) | ((unsigned long)(b) << 8) | (unsigned long)(c))
+
+// Fields of each sentence type by term number, term 0 is the address field.
+// A new sentence only needs a row here and its commit in term_complete()
+const TinyGPS::sentence_format TinyGPS::_formats[_GPS_SENTENCE_OTHER] =
+{
+  // GGA: time, lat, N/S, lon, E/W, quality, satellites, hdop, altitude
+  {{_GPS_FIELD_NONE, _GPS_FIELD_TIME, _GPS_FIELD_LAT, _GPS_FIELD_NS, _GPS_FIELD_LON, _GPS_FIELD_EW,
+    _GPS_FIELD_QUALITY, _GPS_FIELD_SAT_COUNT, _GPS_FIELD_HDOP, _GPS_FIELD_ALTITUDE}, 9, true},
+  // RMC: time, status, lat, N/S, lon, E/W, speed, course, date
+  {{_GPS_FIELD_NONE, _GPS_FIELD_TIME, _GPS_FIELD_STATUS, _GPS_FIELD_LAT, _GPS_FIELD_NS, _GPS_FIELD_LON,
+    _GPS_FIELD_EW, _GPS_FIELD_SPEED, _GPS_FIELD_COURSE, _GPS_FIELD_DATE}, 9, true},
+  // GSV: messages, message number, satellites in view, then satellite details
+  {{_GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_SATS_IN_VIEW}, 3, false},
+  // GSA: selection mode, fix mode, 12 satellite ids, pdop, hdop, vdop
+  {{_GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_FIX_MODE,
+    _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT,
+    _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT,
+    _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT, _GPS_FIELD_ACTIVE_SAT,
+    _GPS_FIELD_PDOP, _GPS_FIELD_NONE, _GPS_FIELD_VDOP}, 17, false},
+  // GST: time, range rms, error ellipse (3 terms), lat, lon and alt error
+  {{_GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_RANGE_RMS, _GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_NONE,
+    _GPS_FIELD_LAT_ERR, _GPS_FIELD_LON_ERR, _GPS_FIELD_ALT_ERR}, 8, false},
+  // VTG: course, T, magnetic course, M, speed, N, speed in km/h, K, mode
+  {{_GPS_FIELD_NONE, _GPS_FIELD_COURSE, _GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_SPEED,
+    _GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_NONE, _GPS_FIELD_MODE}, 9, false},
+  // GLL: lat, N/S, lon, E/W, time, status
+  {{_GPS_FIELD_NONE, _GPS_FIELD_LAT, _GPS_FIELD_NS, _GPS_FIELD_LON, _GPS_FIELD_EW, _GPS_FIELD_TIME,
+    _GPS_FIELD_STATUS}, 6, true},
+  // ZDA: time, day, month, year
+  {{_GPS_FIELD_NONE, _GPS_FIELD_TIME, _GPS_FIELD_DAY, _GPS_FIELD_MONTH, _GPS_FIELD_YEAR}, 4, false}
+};
 
 TinyGPS::TinyGPS()
 :  _time(GPS_INVALID_TIME)
+,  _new_time(GPS_INVALID_TIME)
 ,  _date(GPS_INVALID_DATE)
+,  _new_date(GPS_INVALID_DATE)
 ,  _latitude(GPS_INVALID_ANGLE)
+,  _new_latitude(GPS_INVALID_ANGLE)
 ,  _longitude(GPS_INVALID_ANGLE)
+,  _new_longitude(GPS_INVALID_ANGLE)
+,  _latitude_hr(GPS_INVALID_ANGLE_HR)
+,  _new_latitude_hr(GPS_INVALID_ANGLE_HR)
+,  _longitude_hr(GPS_INVALID_ANGLE_HR)
+,  _new_longitude_hr(GPS_INVALID_ANGLE_HR)
 ,  _altitude(GPS_INVALID_ALTITUDE)
+,  _new_altitude(GPS_INVALID_ALTITUDE)
 ,  _speed(GPS_INVALID_SPEED)
+,  _new_speed(GPS_INVALID_SPEED)
 ,  _course(GPS_INVALID_ANGLE)
+,  _new_course(GPS_INVALID_ANGLE)
 ,  _hdop(0)
+,  _new_hdop(0)
 ,  _sat_count(0)
+,  _new_sat_count(0)
+,  _pdop(0)
+,  _new_pdop(0)
+,  _vdop(0)
+,  _new_vdop(0)
+,  _fix_mode(0)
+,  _new_fix_mode(0)
+,  _active_sat_count(0)
+,  _new_active_sat_count(0)
+,  _sats_in_view(0)
+,  _new_sats_in_view(0)
+,  _range_rms(GPS_INVALID_ERROR)
+,  _new_range_rms(GPS_INVALID_ERROR)
+,  _lat_err(GPS_INVALID_ERROR)
+,  _new_lat_err(GPS_INVALID_ERROR)
+,  _lon_err(GPS_INVALID_ERROR)
+,  _new_lon_err(GPS_INVALID_ERROR)
+,  _alt_err(GPS_INVALID_ERROR)
+,  _new_alt_err(GPS_INVALID_ERROR)
 ,  _last_time_fix(GPS_INVALID_FIX_TIME)
+,  _new_time_fix(GPS_INVALID_FIX_TIME)
 ,  _last_position_fix(GPS_INVALID_FIX_TIME)
+,  _new_position_fix(GPS_INVALID_FIX_TIME)
 ,  _parity(0)
 ,  _is_checksum_term(false)
 ,  _sentence_type(_GPS_SENTENCE_OTHER)
 ,  _term_number(0)
 ,  _term_offset(0)
+,  _date_fields(0)
 ,  _gps_data_good(false)
 ,  _rmc_ready(false)
 ,  _gga_ready(false)
 ,  _gsv_ready(false)
+,  _gsa_ready(false)
+,  _gst_ready(false)
+,  _vtg_ready(false)
+,  _gll_ready(false)
+,  _zda_ready(false)
 #ifndef _GPS_NO_STATS
 ,  _encoded_characters(0)
 ,  _good_sentences(0)
@@ -62,9 +140,107 @@ TinyGPS::TinyGPS()
 
 bool TinyGPS::encode(char c)
 {
-  bool valid_sentence = false;
+  PROFILE_SCOPE(GeoSol::PROBE_GPS_ENCODE);
 
   ++_encoded_characters;
+  if (gpsisdelimiter(c))
+    return term_delimiter(c);
+
+  // ordinary characters
+  if (_term_offset < sizeof(_term) - 1)
+    _term[_term_offset++] = c;
+  if (!_is_checksum_term)
+    _parity ^= c;
+
+  return false;
+}
+
+// nonzero if any byte of word w ends a run of skipped terms: *$\r\n
+static inline uint32_t skip_stop_mask(uint32_t w)
+{
+  uint32_t m = 0, x;
+  x = w ^ 0x2A2A2A2Au; m |= (x - 0x01010101u) & ~x;
+  x = w ^ 0x24242424u; m |= (x - 0x01010101u) & ~x;
+  x = w ^ 0x0D0D0D0Du; m |= (x - 0x01010101u) & ~x;
+  x = w ^ 0x0A0A0A0Au; m |= (x - 0x01010101u) & ~x;
+  return m & 0x80808080u;
+}
+
+int TinyGPS::encode(const char *buf, size_t len)
+{
+  PROFILE_SCOPE(GeoSol::PROBE_GPS_ENCODE);
+  const char *p = buf, *end = buf + len;
+  int valid_sentences = 0;
+  uint32_t w, acc;
+  char c;
+
+#ifndef _GPS_NO_STATS
+  _encoded_characters += len;
+#endif
+  while (p < end)
+  {
+    if (!_is_checksum_term && term_skippable())
+    {
+      // nothing up to the checksum is used: only parity is needed, fold it a word at a time
+      acc = 0;
+      while (end - p >= 4)
+      {
+        memcpy(&w, p, 4);
+        if (skip_stop_mask(w))
+          break;
+        acc ^= w;
+        p += 4;
+      }
+      acc ^= acc >> 16;
+      acc ^= acc >> 8;
+      _parity ^= (byte)acc;
+      while (p < end && *p != '*' && *p != '$' && *p != '\r' && *p != '\n')
+        _parity ^= *p++;
+      if (p == end)
+        break;
+      _term_offset = 0;
+    }
+    else
+    {
+      // term that is parsed, copy it with its parity
+      while (p < end && !gpsisdelimiter(c = *p))
+      {
+        if (_term_offset < sizeof(_term) - 1)
+          _term[_term_offset++] = c;
+        if (!_is_checksum_term)
+          _parity ^= c;
+        ++p;
+      }
+      if (p == end)
+        break;
+    }
+
+    if (term_delimiter(*p++))
+      ++valid_sentences;
+  }
+
+  return valid_sentences;
+}
+
+#ifndef _GPS_NO_STATS
+void TinyGPS::stats(unsigned long *chars, unsigned short *sentences, unsigned short *failed_cs)
+{
+  if (chars) *chars = _encoded_characters;
+  if (sentences) *sentences = _good_sentences;
+  if (failed_cs) *failed_cs = _failed_checksum;
+}
+#endif
+
+//
+// internal utilities
+//
+
+// Handles a term or sentence delimiter
+// Returns true if new sentence has just passed checksum test and is validated
+bool TinyGPS::term_delimiter(char c)
+{
+  bool valid_sentence = false;
+
   switch(c)
   {
   case ',': // term terminators
@@ -77,10 +253,12 @@ bool TinyGPS::encode(char c)
       _term[_term_offset] = 0;
       valid_sentence = term_complete();
     }
-    ++_term_number;
+    // saturates past the last decoded term, so overlong sentences neither wrap to term 0 nor index past the tables
+    if (_term_number <= _GPS_LAST_TERM)
+      ++_term_number;
     _term_offset = 0;
     _is_checksum_term = c == '*';
-    return valid_sentence;
+    break;
 
   case '$': // sentence begin
     _term_number = _term_offset = 0;
@@ -88,38 +266,31 @@ bool TinyGPS::encode(char c)
     _sentence_type = _GPS_SENTENCE_OTHER;
     _is_checksum_term = false;
     _gps_data_good = false;
-    return valid_sentence;
+    break;
   }
 
-  // ordinary characters
-  if (_term_offset < sizeof(_term) - 1)
-    _term[_term_offset++] = c;
-  if (!_is_checksum_term)
-    _parity ^= c;
-
   return valid_sentence;
 }
 
-#ifndef _GPS_NO_STATS
-void TinyGPS::stats(unsigned long *chars, unsigned short *sentences, unsigned short *failed_cs)
+// True when the remaining terms of the current sentence carry nothing the parser uses
+bool TinyGPS::term_skippable()
 {
-  if (chars) *chars = _encoded_characters;
-  if (sentences) *sentences = _good_sentences;
-  if (failed_cs) *failed_cs = _failed_checksum;
+  if (_sentence_type == _GPS_SENTENCE_OTHER)
+    return _term_number > 0;
+  return _term_number > _formats[_sentence_type].last_term;
 }
-#endif
 
-//
-// internal utilities
-//
+// Returns -1 for anything but a hex digit
 int TinyGPS::from_hex(char a) 
 {
   if (a >= 'A' && a <= 'F')
     return a - 'A' + 10;
   else if (a >= 'a' && a <= 'f')
     return a - 'a' + 10;
-  else
+  else if (gpsisdigit(a))
     return a - '0';
+  else
+    return -1;
 }
 
 unsigned long TinyGPS::parse_decimal()
@@ -141,66 +312,114 @@ unsigned long TinyGPS::parse_decimal()
   return isneg ? -ret : ret;
 }
 
-unsigned long TinyGPS::parse_degrees()
+// Parses ddmm.mmmm... into ten millionths of a degree, all minute decimals up to 1e-9 minute are used
+// Sets legacy to the value in hundred thousandths of a degree, truncated from four minute decimals as before
+long TinyGPS::parse_degrees(long *legacy)
 {
   char *p;
   unsigned long left = gpsatol(_term);
-  unsigned long tenk_minutes = (left % 100UL) * 10000UL;
+  uint64_t nano_minutes = (uint64_t)(left % 100UL) * 1000000000UL;
   for (p=_term; gpsisdigit(*p); ++p);
   if (*p == '.')
   {
-    unsigned long mult = 1000;
-    while (gpsisdigit(*++p))
+    unsigned long mult = 100000000UL;
+    while (gpsisdigit(*++p) && mult)
     {
-      tenk_minutes += mult * (*p - '0');
+      nano_minutes += mult * (*p - '0');
       mult /= 10;
     }
   }
-  return (left / 100) * 100000 + tenk_minutes / 6;
+  *legacy = (left / 100) * 100000 + (unsigned long)(nano_minutes / 100000) / 6;
+  return (left / 100) * 10000000 + (long)((nano_minutes + 3000) / 6000);
 }
 
 // Processes a just-completed term
-// Returns true if new sentence has just passed checksum test and is validated
+// Returns true if new sentence carrying a fix has just passed checksum test and is validated,
+// other sentences are committed when their checksum passes but return false
 bool TinyGPS::term_complete()
 {
   if (_is_checksum_term)
   {
-    byte checksum = 16 * from_hex(_term[0]) + from_hex(_term[1]);
-    if (checksum == _parity)
+    // exactly two hex digits, a shorter term would compare against stale characters
+    int high = from_hex(_term[0]), low = high < 0 ? -1 : from_hex(_term[1]);
+    if (_term_offset == 2 && low >= 0 && (byte)(16 * high + low) == _parity)
     {
       if (_gps_data_good)
       {
 #ifndef _GPS_NO_STATS
         ++_good_sentences;
 #endif
-        _last_time_fix = _new_time_fix;
-        _last_position_fix = _new_position_fix;
-
         switch(_sentence_type)
         {
-        case _GPS_SENTENCE_GPRMC:
+        case _GPS_SENTENCE_RMC:
+          _last_time_fix = _new_time_fix;
+          _last_position_fix = _new_position_fix;
           _time      = _new_time;
           _date      = _new_date;
           _latitude  = _new_latitude;
           _longitude = _new_longitude;
+          _latitude_hr  = _new_latitude_hr;
+          _longitude_hr = _new_longitude_hr;
           _speed     = _new_speed;
           _course    = _new_course;
           _rmc_ready = true;
           break;
-        case _GPS_SENTENCE_GPGGA:
+        case _GPS_SENTENCE_GGA:
+          _last_time_fix = _new_time_fix;
+          _last_position_fix = _new_position_fix;
           _altitude  = _new_altitude;
           _time      = _new_time;
           _latitude  = _new_latitude;
           _longitude = _new_longitude;
+          _latitude_hr  = _new_latitude_hr;
+          _longitude_hr = _new_longitude_hr;
           _gga_ready = true;
           _hdop      = _new_hdop;
           _sat_count = _new_sat_count;
-        case _GPS_SENTENCE_GPGSV:
+          break;
+        case _GPS_SENTENCE_GLL:
+          _last_time_fix = _new_time_fix;
+          _last_position_fix = _new_position_fix;
+          _time      = _new_time;
+          _latitude  = _new_latitude;
+          _longitude = _new_longitude;
+          _latitude_hr  = _new_latitude_hr;
+          _longitude_hr = _new_longitude_hr;
+          _gll_ready = true;
+          break;
+        case _GPS_SENTENCE_GSV:
+          _sats_in_view = _new_sats_in_view;
           _gsv_ready = true;
           break;
+        case _GPS_SENTENCE_GSA:
+          _fix_mode  = _new_fix_mode;
+          _pdop      = _new_pdop;
+          _vdop      = _new_vdop;
+          memcpy(_active_sats, _new_active_sats, _new_active_sat_count);
+          _active_sat_count = _new_active_sat_count;
+          _gsa_ready = true;
+          break;
+        case _GPS_SENTENCE_GST:
+          _range_rms = _new_range_rms;
+          _lat_err   = _new_lat_err;
+          _lon_err   = _new_lon_err;
+          _alt_err   = _new_alt_err;
+          _gst_ready = true;
+          break;
+        case _GPS_SENTENCE_VTG:
+          _speed     = _new_speed;
+          _course    = _new_course;
+          _vtg_ready = true;
+          break;
+        case _GPS_SENTENCE_ZDA:
+          _last_time_fix = _new_time_fix;
+          _time      = _new_time;
+          _date      = _new_date;
+          _zda_ready = true;
+          break;
         }
 
-        return true;
+        return _formats[_sentence_type].has_status;
       }
     }
 
@@ -211,87 +430,139 @@ bool TinyGPS::term_complete()
     return false;
   }
 
-  // the first term determines the sentence type
+  // the first term determines the sentence type: two talker characters (GP, GN, GL, GA, BD...)
+  // followed by three formatter characters, proprietary sentences start with P and are not parsed
   if (_term_number == 0)
   {
-    if (!gpsstrcmp(_term, _GPRMC_TERM))
-      _sentence_type = _GPS_SENTENCE_GPRMC;
-    else if (!gpsstrcmp(_term, _GPGGA_TERM))
-      _sentence_type = _GPS_SENTENCE_GPGGA;
-    else if (!gpsstrcmp(_term, _GPGSV_TERM))
-      _sentence_type = _GPS_SENTENCE_GPGSV;
-    else
-      _sentence_type = _GPS_SENTENCE_OTHER;
+    _sentence_type = _GPS_SENTENCE_OTHER;
+    if (_term_offset == 5 && _term[0] != 'P')
+      switch(_GPS_FORMATTER(_term[2], _term[3], _term[4]))
+      {
+      case _GPS_FORMATTER('R', 'M', 'C'): _sentence_type = _GPS_SENTENCE_RMC; break;
+      case _GPS_FORMATTER('G', 'G', 'A'): _sentence_type = _GPS_SENTENCE_GGA; break;
+      case _GPS_FORMATTER('G', 'S', 'V'): _sentence_type = _GPS_SENTENCE_GSV; break;
+      case _GPS_FORMATTER('G', 'S', 'A'): _sentence_type = _GPS_SENTENCE_GSA; break;
+      case _GPS_FORMATTER('G', 'S', 'T'): _sentence_type = _GPS_SENTENCE_GST; break;
+      case _GPS_FORMATTER('V', 'T', 'G'): _sentence_type = _GPS_SENTENCE_VTG; break;
+      case _GPS_FORMATTER('G', 'L', 'L'): _sentence_type = _GPS_SENTENCE_GLL; break;
+      case _GPS_FORMATTER('Z', 'D', 'A'): _sentence_type = _GPS_SENTENCE_ZDA; break;
+      }
+    // sentences without a status field are good unless a field says otherwise,
+    // ZDA only once its year completes a date, empty terms would leave parts of an older one
+    _gps_data_good = _sentence_type != _GPS_SENTENCE_OTHER && !_formats[_sentence_type].has_status &&
+      _sentence_type != _GPS_SENTENCE_ZDA;
+    _new_active_sat_count = 0;
+    _date_fields = 0;
     return false;
   }
 
-  if (_sentence_type != _GPS_SENTENCE_OTHER && _term[0])
-  switch((_sentence_type == _GPS_SENTENCE_GPGGA ? 200 : 100) + _term_number)
+  if (_sentence_type == _GPS_SENTENCE_OTHER || _term_number > _GPS_LAST_TERM || !_term[0])
+    return false;
+
+  switch(_formats[_sentence_type].fields[_term_number])
   {
-    case 101: // Time in both sentences
-    case 201:
+    case _GPS_FIELD_TIME:
       _new_time = parse_decimal();
       _new_time_fix = millis();
       break;
-    case 102: // GPRMC validity
+    case _GPS_FIELD_STATUS: // RMC and GLL validity
       _gps_data_good = _term[0] == 'A';
       break;
-    case 103: // Latitude
-    case 202:
-      _new_latitude = parse_degrees();
+    case _GPS_FIELD_LAT:
+      _new_latitude_hr = parse_degrees(&_new_latitude);
       _new_position_fix = millis();
       break;
-    case 104: // N/S
-    case 203:
+    case _GPS_FIELD_NS:
       if (_term[0] == 'S')
+      {
         _new_latitude = -_new_latitude;
+        _new_latitude_hr = -_new_latitude_hr;
+      }
       break;
-    case 105: // Longitude
-    case 204:
-      _new_longitude = parse_degrees();
+    case _GPS_FIELD_LON:
+      _new_longitude_hr = parse_degrees(&_new_longitude);
       break;
-    case 106: // E/W
-    case 205:
+    case _GPS_FIELD_EW:
       if (_term[0] == 'W')
+      {
         _new_longitude = -_new_longitude;
+        _new_longitude_hr = -_new_longitude_hr;
+      }
       break;
-    case 107: // Speed (GPRMC)
+    case _GPS_FIELD_SPEED:
       _new_speed = parse_decimal();
       break;
-    case 108: // Course (GPRMC)
+    case _GPS_FIELD_COURSE:
       _new_course = parse_decimal();
       break;
-    case 109: // Date (GPRMC)
+    case _GPS_FIELD_DATE:
       _new_date = gpsatol(_term);
       break;
-    case 206: // Fix data (GPGGA)
+    case _GPS_FIELD_QUALITY: // GGA validity
       _gps_data_good = _term[0] > '0';
       break;
-    case 207: // Number of satelites tracked (GPGGA)
-      _new_sat_count = parse_decimal();
+    case _GPS_FIELD_SAT_COUNT:
+      _new_sat_count = gpsatol(_term);
       break;
-    case 208: // Horizontal Dilution of Position (GPGGA)
+    case _GPS_FIELD_HDOP:
       _new_hdop = parse_decimal();
       break;
-    case 209: // Altitude (GPGGA)
+    case _GPS_FIELD_ALTITUDE:
       _new_altitude = parse_decimal();
       break;
+    case _GPS_FIELD_SATS_IN_VIEW:
+      _new_sats_in_view = gpsatol(_term);
+      break;
+    case _GPS_FIELD_FIX_MODE:
+      _new_fix_mode = gpsatol(_term);
+      break;
+    case _GPS_FIELD_ACTIVE_SAT: // empty terms are skipped above, so the list is packed
+      if (_new_active_sat_count < _GPS_MAX_ACTIVE_SATS)
+        _new_active_sats[_new_active_sat_count++] = gpsatol(_term);
+      break;
+    case _GPS_FIELD_PDOP:
+      _new_pdop = parse_decimal();
+      break;
+    case _GPS_FIELD_VDOP:
+      _new_vdop = parse_decimal();
+      break;
+    case _GPS_FIELD_RANGE_RMS:
+      _new_range_rms = parse_decimal();
+      break;
+    case _GPS_FIELD_LAT_ERR:
+      _new_lat_err = parse_decimal();
+      break;
+    case _GPS_FIELD_LON_ERR:
+      _new_lon_err = parse_decimal();
+      break;
+    case _GPS_FIELD_ALT_ERR:
+      _new_alt_err = parse_decimal();
+      break;
+    case _GPS_FIELD_MODE: // VTG validity, NMEA 2.3 and later
+      _gps_data_good = _term[0] != 'N';
+      break;
+    case _GPS_FIELD_DAY:
+      _new_date = gpsatol(_term) * 10000;
+      ++_date_fields;
+      break;
+    case _GPS_FIELD_MONTH:
+      _new_date += gpsatol(_term) * 100;
+      ++_date_fields;
+      break;
+    case _GPS_FIELD_YEAR: // ddmmyy as in RMC
+      _new_date += gpsatol(_term) % 100;
+      _gps_data_good = _date_fields == 2;
+      break;
   } /* switch */
 
   return false;
 }
 
-long TinyGPS::gpsatol(const char *str)
+// Wraps around instead of overflowing on overlong terms
+unsigned long TinyGPS::gpsatol(const char *str)
 {
-  long ret = 0;
+  unsigned long ret = 0;
   while (gpsisdigit(*str))
     ret = 10 * ret + *str++ - '0';
   return ret;
 }
-
-int TinyGPS::gpsstrcmp(const char *str1, const char *str2)
-{
-  while (*str1 && *str1 == *str2)
-    ++str1, ++str2;
-  return *str1;
-}
@@ -20,8 +20,13 @@
   Ported to mbed by Michael Shimniok
 */
 
+#ifdef GEOSOL_HOST
+#include <stddef.h>
+#else
 #include "mbed.h"
+#endif
 #include "types.h"
+#include <stdint.h>
 
 #ifndef TinyGPS_h
 #define TinyGPS_h
@@ -45,10 +50,23 @@ class TinyGPS
     /** Parse a single character received from GPS
      *
      * @param c is the character received from the GPS
-     * @returns true if processing ok
+     * @returns true if c completed a valid RMC, GGA or GLL sentence, see encode(const char *, size_t)
      */
     bool encode(char c);
     
+    /** Parse a chunk of characters received from GPS
+     *
+     * Terms that the parser does not use are skipped four bytes at a time,
+     * only their parity is accumulated
+     *
+     * @param buf points to the received characters
+     * @param len is the number of characters in buf
+     * @returns number of RMC, GGA and GLL sentences in buf that passed checksum test and report a fix
+     * (status A, quality above 0); GSV, GSA, GST, VTG and ZDA sentences are committed when their
+     * checksum passes but are not counted, so a nonzero result means a new position
+     */
+    int encode(const char *buf, size_t len);
+    
     /** Shorthand operator for encode()
      */
     TinyGPS &operator << (char c) {encode(c); return *this;}
@@ -66,6 +84,22 @@ class TinyGPS
         GPS_INVALID_AGE : millis() - _last_position_fix;
     }
 
+    /** Return lat/long in ten millionths of a degree and age of fix in milliseconds
+     *
+     * All minute decimals sent by the receiver are used, down to 1e-9 minute,
+     * so positions of survey-grade receivers keep their resolution
+     * @returns latitude is the latitude of the most recent fix that was parsed
+     * @returns longitude is the longitude of the most recent fix that was parsed
+     * @returns fix_age is the age of the fix (if available from the NMEA sentences being parsed)
+     */
+    inline void get_position_hr(int32_t *latitude, int32_t *longitude, unsigned long *fix_age = 0)
+    {
+      if (latitude) *latitude = _latitude_hr;
+      if (longitude) *longitude = _longitude_hr;
+      if (fix_age) *fix_age = _last_position_fix == GPS_INVALID_FIX_TIME ? 
+        GPS_INVALID_AGE : millis() - _last_position_fix;
+    }
+
     /** Return the date and time from the parsed NMEA sentences
      *
      * @returns date as an integer value
@@ -80,31 +114,79 @@ class TinyGPS
         GPS_INVALID_AGE : millis() - _last_time_fix;
     }
 
-    /** signed altitude in centimeters (from GPGGA sentence)
+    /** signed altitude in centimeters (from GGA sentence)
      * @returns altitude in centimeters, integer
      */
     inline long altitude() { return _altitude; }
 
-    /** course in last full GPRMC sentence in 100th of a degree
+    /** course in last full RMC or VTG sentence in 100th of a degree
      * @returns course as an integer, 100ths of a degree
      */
     inline unsigned long course() { return _course; }
     
-    /** speed in last full GPRMC sentence in 100ths of a knot
+    /** speed in last full RMC or VTG sentence in 100ths of a knot
      * @returns speed in 100ths of a knot
      */
     unsigned long speed() { return _speed; }
 
-    /* horizontal dilution of position in last full GPGGA sentence in 100ths
+    /* horizontal dilution of position in last full GGA sentence in 100ths
      * @returns hdop in 100ths
      */
     unsigned long hdop() { return _hdop; }
 
-    /** number of satellites tracked in last full GPGGA sentence
+    /** number of satellites tracked in last full GGA sentence
      * @returns number of satellites tracked 
      */
     unsigned long sat_count() { return _sat_count; }
 
+    /** position and vertical dilution of precision in last full GSA sentence in 100ths
+     * @returns pdop in 100ths
+     */
+    unsigned long pdop() { return _pdop; }
+
+    /** @returns vdop in 100ths
+     */
+    unsigned long vdop() { return _vdop; }
+
+    /** fix mode in last full GSA sentence
+     * @returns 1 for no fix, 2 for 2D fix, 3 for 3D fix, 0 if unknown
+     */
+    unsigned int fix_mode() { return _fix_mode; }
+
+    /** satellites used for the fix in last full GSA sentence
+     *
+     * Receivers tracking several constellations send one GSA per constellation,
+     * the list holds the satellites of the last one
+     * @returns number of satellites in the list, up to 12
+     */
+    unsigned int active_sat_count() { return _active_sat_count; }
+
+    /** @returns satellite ids used for the fix, active_sat_count() entries
+     */
+    const unsigned char *active_sats() { return _active_sats; }
+
+    /** number of satellites in view from last full GSV sentence
+     * @returns number of satellites in view
+     */
+    unsigned int sats_in_view() { return _sats_in_view; }
+
+    /** standard deviation of pseudorange residuals in last full GST sentence
+     * @returns rms in centimeters, GPS_INVALID_ERROR if unknown
+     */
+    unsigned long range_rms() { return _range_rms; }
+
+    /** standard deviations of position error in last full GST sentence
+     * @returns lat_err latitude error in centimeters, GPS_INVALID_ERROR if unknown
+     * @returns lon_err longitude error in centimeters
+     * @returns alt_err altitude error in centimeters
+     */
+    inline void get_errors(unsigned long *lat_err, unsigned long *lon_err, unsigned long *alt_err)
+    {
+      if (lat_err) *lat_err = _lat_err;
+      if (lon_err) *lon_err = _lon_err;
+      if (alt_err) *alt_err = _alt_err;
+    }
+
 #ifndef _GPS_NO_STATS
     void stats(unsigned long *chars, unsigned short *good_sentences, unsigned short *failed_cs);
 #endif
@@ -195,41 +277,103 @@ class TinyGPS
     /** determine if GSV sentence parsed since last reset_ready()
      */
     inline bool gsv_ready() { return _gsv_ready; }
+
+    /** determine if GSA sentence parsed since last reset_ready()
+     */
+    inline bool gsa_ready() { return _gsa_ready; }
+
+    /** determine if GST sentence parsed since last reset_ready()
+     */
+    inline bool gst_ready() { return _gst_ready; }
+
+    /** determine if VTG sentence parsed since last reset_ready()
+     */
+    inline bool vtg_ready() { return _vtg_ready; }
+
+    /** determine if GLL sentence parsed since last reset_ready()
+     */
+    inline bool gll_ready() { return _gll_ready; }
+
+    /** determine if ZDA sentence parsed since last reset_ready()
+     */
+    inline bool zda_ready() { return _zda_ready; }
     
     /** Reset the ready flags for all the parsed sentences
      */
-    inline void reset_ready() { _gsv_ready = _rmc_ready = _gga_ready = false; }
+    inline void reset_ready()
+    {
+      _gsv_ready = _rmc_ready = _gga_ready = false;
+      _gsa_ready = _gst_ready = _vtg_ready = _gll_ready = _zda_ready = false;
+    }
 
     enum {GPS_INVALID_AGE = 0xFFFFFFFF, GPS_INVALID_ANGLE = 999999999, GPS_INVALID_ALTITUDE = 999999999, GPS_INVALID_DATE = 0,
-      GPS_INVALID_TIME = 0xFFFFFFFF, GPS_INVALID_SPEED = 999999999, GPS_INVALID_FIX_TIME = 0xFFFFFFFF};
+      GPS_INVALID_TIME = 0xFFFFFFFF, GPS_INVALID_SPEED = 999999999, GPS_INVALID_FIX_TIME = 0xFFFFFFFF,
+      GPS_INVALID_ANGLE_HR = 2147483647, GPS_INVALID_ERROR = 0xFFFFFFFF};
 
 private:
-    enum {_GPS_SENTENCE_GPGGA, _GPS_SENTENCE_GPRMC, _GPS_SENTENCE_GPGSV, _GPS_SENTENCE_OTHER};
+    enum {_GPS_SENTENCE_GGA, _GPS_SENTENCE_RMC, _GPS_SENTENCE_GSV, _GPS_SENTENCE_GSA, _GPS_SENTENCE_GST,
+      _GPS_SENTENCE_VTG, _GPS_SENTENCE_GLL, _GPS_SENTENCE_ZDA, _GPS_SENTENCE_OTHER};
+    enum {_GPS_LAST_TERM = 17}; // highest term number used in any sentence
+    enum {_GPS_MAX_ACTIVE_SATS = 12};
+
+    // what term_complete() does with a term
+    enum {_GPS_FIELD_NONE, _GPS_FIELD_TIME, _GPS_FIELD_STATUS, _GPS_FIELD_LAT, _GPS_FIELD_NS, _GPS_FIELD_LON,
+      _GPS_FIELD_EW, _GPS_FIELD_SPEED, _GPS_FIELD_COURSE, _GPS_FIELD_DATE, _GPS_FIELD_QUALITY, _GPS_FIELD_SAT_COUNT,
+      _GPS_FIELD_HDOP, _GPS_FIELD_ALTITUDE, _GPS_FIELD_SATS_IN_VIEW, _GPS_FIELD_FIX_MODE, _GPS_FIELD_ACTIVE_SAT,
+      _GPS_FIELD_PDOP, _GPS_FIELD_VDOP, _GPS_FIELD_RANGE_RMS, _GPS_FIELD_LAT_ERR, _GPS_FIELD_LON_ERR,
+      _GPS_FIELD_ALT_ERR, _GPS_FIELD_MODE, _GPS_FIELD_DAY, _GPS_FIELD_MONTH, _GPS_FIELD_YEAR};
+
+    // layout of one sentence type
+    struct sentence_format
+    {
+      byte fields[_GPS_LAST_TERM + 1]; // field decoded from each term, indexed by term number
+      byte last_term;                  // terms after this one are not decoded
+      bool has_status;                 // carries a fix and is validated by a status field, else by checksum alone
+    };
+    static const sentence_format _formats[_GPS_SENTENCE_OTHER];
     
     // properties
     unsigned long _time, _new_time;
     unsigned long _date, _new_date;
     long _latitude, _new_latitude;
     long _longitude, _new_longitude;
+    int32_t _latitude_hr, _new_latitude_hr;
+    int32_t _longitude_hr, _new_longitude_hr;
     long _altitude, _new_altitude;
     unsigned long  _speed, _new_speed;
     unsigned long  _course, _new_course;
     unsigned long  _hdop, _new_hdop;
     unsigned int _sat_count, _new_sat_count;
+    unsigned long _pdop, _new_pdop;
+    unsigned long _vdop, _new_vdop;
+    byte _fix_mode, _new_fix_mode;
+    unsigned char _active_sats[_GPS_MAX_ACTIVE_SATS], _new_active_sats[_GPS_MAX_ACTIVE_SATS];
+    byte _active_sat_count, _new_active_sat_count;
+    unsigned int _sats_in_view, _new_sats_in_view;
+    unsigned long _range_rms, _new_range_rms;
+    unsigned long _lat_err, _new_lat_err;
+    unsigned long _lon_err, _new_lon_err;
+    unsigned long _alt_err, _new_alt_err;
     unsigned long _last_time_fix, _new_time_fix;
     unsigned long _last_position_fix, _new_position_fix;
 
     // parsing state variables
     byte _parity;
     bool _is_checksum_term;
-    char _term[15];
+    char _term[20];
     byte _sentence_type;
     byte _term_number;
     byte _term_offset;
+    byte _date_fields;      // non-empty ZDA day and month terms of this sentence
     bool _gps_data_good;
     bool _rmc_ready;
     bool _gga_ready;
     bool _gsv_ready;
+    bool _gsa_ready;
+    bool _gst_ready;
+    bool _vtg_ready;
+    bool _gll_ready;
+    bool _zda_ready;
 
 #ifndef _GPS_NO_STATS
     // statistics
@@ -242,11 +386,13 @@ private:
     // internal utilities
     int from_hex(char a);
     unsigned long parse_decimal();
-    unsigned long parse_degrees();
+    long parse_degrees(long *legacy);
     bool term_complete();
+    bool term_delimiter(char c);
+    bool term_skippable();
     bool gpsisdigit(char c) { return c >= '0' && c <= '9'; }
-    long gpsatol(const char *str);
-    int gpsstrcmp(const char *str1, const char *str2);
+    bool gpsisdelimiter(char c) { return c == ',' || c == '\r' || c == '\n' || c == '*' || c == '$'; }
+    unsigned long gpsatol(const char *str);
 };
 
 // Arduino 0012 workaround
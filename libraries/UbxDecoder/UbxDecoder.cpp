@@ -0,0 +1,130 @@
+// UbxDecoder.cpp
+//state machine of UBX frame decoder
+
+#include "UbxDecoder.h"
+#include <string.h>
+
+namespace GeoSol {
+
+    static const uint8_t SYNC_CHAR1 = 0xB5;
+    static const uint8_t SYNC_CHAR2 = 0x62;
+    static const uint8_t CLASS_NAV = 0x01;
+    static const uint8_t ID_NAV_PVT = 0x07;
+    static const uint8_t ID_NAV_HPPOSLLH = 0x14;
+
+    UbxDecoder::UbxDecoder() : _state(SYNC1), _class(0), _id(0), _length(0), _offset(0), _ckA(0), _ckB(0),
+        _frames(0), _failed(0), _dropped(0) {
+        memset(&_payload, 0, sizeof(_payload));
+    }
+
+    //checksum of frame is good, classify it
+    UbxMessage UbxDecoder::complete() {
+        _frames++;
+        if (_class == CLASS_NAV && _id == ID_NAV_PVT && _length == sizeof(UbxNavPvt))
+            return UBX_NAV_PVT;
+        if (_class == CLASS_NAV && _id == ID_NAV_HPPOSLLH && _length == sizeof(UbxNavHpposllh))
+            return UBX_NAV_HPPOSLLH;
+        return UBX_OTHER;
+    }
+
+    UbxMessage UbxDecoder::encode(uint8_t c) {
+        switch (_state) {
+        case SYNC1:
+            if (c == SYNC_CHAR1)
+                _state = SYNC2;
+            break;
+        case SYNC2:
+            _state = c == SYNC_CHAR2 ? CLASS : c == SYNC_CHAR1 ? SYNC2 : SYNC1;
+            break;
+        case CLASS:
+            _class = _ckA = _ckB = c;
+            _state = ID;
+            break;
+        case ID:
+            _id = c;
+            _ckA += c;
+            _ckB += _ckA;
+            _state = LENGTH1;
+            break;
+        case LENGTH1:
+            _length = c;
+            _ckA += c;
+            _ckB += _ckA;
+            _state = LENGTH2;
+            break;
+        case LENGTH2:
+            _length |= (uint16_t)c << 8;
+            //a corrupted length would swallow up to 64 kB of good frames before its checksum fails,
+            //so anything longer than the frames kept counts as noise and the sync search goes on
+            if (_length > MAX_PAYLOAD) {
+                _dropped++;
+                _state = SYNC1;
+                break;
+            }
+            _ckA += c;
+            _ckB += _ckA;
+            _offset = 0;
+            _state = _length ? PAYLOAD : CK_A;
+            break;
+        case PAYLOAD:
+            _payload.raw[_offset] = c;
+            _ckA += c;
+            _ckB += _ckA;
+            if (++_offset == _length)
+                _state = CK_A;
+            break;
+        case CK_A:
+            _state = c == _ckA ? CK_B : SYNC1;
+            if (c != _ckA)
+                _failed++;
+            break;
+        case CK_B:
+            _state = SYNC1;
+            if (c == _ckB)
+                return complete();
+            _failed++;
+            break;
+        }
+        return UBX_NONE;
+    }
+
+    size_t UbxDecoder::encode(const uint8_t* buf, size_t len, UbxMessage& msg) {
+        const uint8_t *p = buf, *end = buf + len;
+        size_t n, i;
+        uint8_t a, b;
+
+        msg = UBX_NONE;
+        while (p < end) {
+            if (_state == PAYLOAD) {
+                //payload runs straight from the receive buffer into place, checksum in registers
+                n = _length - _offset;
+                if (n > (size_t)(end - p))
+                    n = end - p;
+                memcpy(_payload.raw + _offset, p, n);
+                a = _ckA;
+                b = _ckB;
+                for (i = 0; i < n; i++) {
+                    a += p[i];
+                    b += a;
+                }
+                _ckA = a;
+                _ckB = b;
+                _offset += n;
+                p += n;
+                if (_offset == _length)
+                    _state = CK_A;
+                continue;
+            }
+            msg = encode(*p++);
+            if (msg != UBX_NONE)
+                break;
+        }
+        return p - buf;
+    }
+
+    void UbxDecoder::stats(unsigned long* frames, unsigned long* failed, unsigned long* dropped) const {
+        if (frames) *frames = _frames;
+        if (failed) *failed = _failed;
+        if (dropped) *dropped = _dropped;
+    }
+}
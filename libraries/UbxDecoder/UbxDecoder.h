@@ -0,0 +1,149 @@
+// UbxDecoder.h
+//decoder of u-blox UBX binary frames, runs next to TinyGPS on the same or another serial port
+
+#ifndef UBXDECODER_H
+#define UBXDECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace GeoSol
+{
+    //payloads are laid out exactly as on the wire, little-endian like Cortex-M4 and x86
+#pragma pack(push, 1)
+
+    //UBX-NAV-PVT: navigation position velocity time solution
+    struct UbxNavPvt
+    {
+        uint32_t iTOW;      //GPS time of week, ms
+        uint16_t year;
+        uint8_t month;
+        uint8_t day;
+        uint8_t hour;
+        uint8_t min;
+        uint8_t sec;
+        uint8_t valid;      //validity flags of date and time
+        uint32_t tAcc;      //time accuracy, ns
+        int32_t nano;       //fraction of second, ns
+        uint8_t fixType;    //0 no fix, 2 2D, 3 3D, 4 GNSS and dead reckoning, 5 time only
+        uint8_t flags;      //bit 0: fix within accuracy limits
+        uint8_t flags2;
+        uint8_t numSV;      //satellites used
+        int32_t lon;        //ten millionths of a degree
+        int32_t lat;        //ten millionths of a degree
+        int32_t height;     //above ellipsoid, mm
+        int32_t hMSL;       //above mean sea level, mm
+        uint32_t hAcc;      //horizontal accuracy, mm
+        uint32_t vAcc;      //vertical accuracy, mm
+        int32_t velN;       //mm/s
+        int32_t velE;       //mm/s
+        int32_t velD;       //mm/s
+        int32_t gSpeed;     //ground speed, mm/s
+        int32_t headMot;    //heading of motion, 1e-5 degree
+        uint32_t sAcc;      //speed accuracy, mm/s
+        uint32_t headAcc;   //heading accuracy, 1e-5 degree
+        uint16_t pDOP;      //0.01
+        uint8_t flags3;
+        uint8_t reserved1[5];
+        int32_t headVeh;    //heading of vehicle, 1e-5 degree
+        int16_t magDec;     //magnetic declination, 1e-2 degree
+        uint16_t magAcc;
+    };
+
+    //UBX-NAV-HPPOSLLH: high precision geodetic position
+    struct UbxNavHpposllh
+    {
+        uint8_t version;
+        uint8_t reserved1[2];
+        uint8_t flags;      //bit 0: position not valid
+        uint32_t iTOW;      //GPS time of week, ms
+        int32_t lon;        //ten millionths of a degree
+        int32_t lat;        //ten millionths of a degree
+        int32_t height;     //above ellipsoid, mm
+        int32_t hMSL;       //above mean sea level, mm
+        int8_t lonHp;       //nanodegrees to add to lon * 100
+        int8_t latHp;       //nanodegrees to add to lat * 100
+        int8_t heightHp;    //0.1 mm to add to height
+        int8_t hMSLHp;      //0.1 mm to add to hMSL
+        uint32_t hAcc;      //horizontal accuracy, 0.1 mm
+        uint32_t vAcc;      //vertical accuracy, 0.1 mm
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(UbxNavPvt) == 92, "UBX-NAV-PVT payload is 92 bytes");
+    static_assert(sizeof(UbxNavHpposllh) == 36, "UBX-NAV-HPPOSLLH payload is 36 bytes");
+
+    //frames recognised by UbxDecoder
+    enum UbxMessage
+    {
+        UBX_NONE,           //no frame completed
+        UBX_NAV_PVT,
+        UBX_NAV_HPPOSLLH,
+        UBX_OTHER           //frame with good checksum, payload in payload()
+    };
+
+    //Streaming decoder of UBX frames: sync chars 0xB5 0x62, class, id, little-endian length, payload and
+    //8-bit Fletcher checksum over class to the end of payload. Payload bytes are stored once, straight into
+    //a buffer overlaid with the packed message structs, and the structs are read in place without copying.
+    //A decoded message stays valid until the next byte is passed to the decoder.
+    //NMEA text between frames is ignored, so both protocols may share one port
+    class UbxDecoder
+    {
+    public:
+
+        //Longest payload accepted. A longer length field is taken for corruption: the frame is counted as
+        //dropped and the decoder searches for the next sync chars right after it
+        static const size_t MAX_PAYLOAD = 100;
+
+        UbxDecoder();
+
+        //Feeds one byte, returns the message completed by it
+        UbxMessage encode(uint8_t c);
+
+        //Feeds up to len bytes and stops right after the first completed frame,
+        //msg receives the message, or UBX_NONE if the whole buffer was used without completing a frame.
+        //Returns number of bytes consumed
+        size_t encode(const uint8_t* buf, size_t len, UbxMessage& msg);
+
+        //Last completed NAV-PVT, valid after encode() returned UBX_NAV_PVT
+        const UbxNavPvt& navPvt() const { return _payload.pvt; }
+
+        //Last completed NAV-HPPOSLLH, valid after encode() returned UBX_NAV_HPPOSLLH
+        const UbxNavHpposllh& navHpposllh() const { return _payload.hpposllh; }
+
+        //Class, id, length and payload of the last completed frame
+        uint8_t msgClass() const { return _class; }
+        uint8_t msgId() const { return _id; }
+        uint16_t length() const { return _length; }
+        const uint8_t* payload() const { return _payload.raw; }
+
+        //Counts of good frames, frames failing checksum and frames dropped for a length above MAX_PAYLOAD
+        void stats(unsigned long* frames, unsigned long* failed, unsigned long* dropped) const;
+
+        //Returns latitude and longitude of NAV-HPPOSLLH in nanodegrees
+        static int64_t latNano(const UbxNavHpposllh& pos) { return (int64_t)pos.lat * 100 + pos.latHp; }
+        static int64_t lonNano(const UbxNavHpposllh& pos) { return (int64_t)pos.lon * 100 + pos.lonHp; }
+
+    private:
+
+        enum State { SYNC1, SYNC2, CLASS, ID, LENGTH1, LENGTH2, PAYLOAD, CK_A, CK_B };
+
+        UbxMessage complete();
+
+        State _state;
+        uint8_t _class, _id;
+        uint16_t _length, _offset;
+        uint8_t _ckA, _ckB;
+
+        union {
+            uint8_t raw[MAX_PAYLOAD];
+            UbxNavPvt pvt;
+            UbxNavHpposllh hpposllh;
+        } _payload;
+
+        unsigned long _frames, _failed, _dropped;
+    };
+}
+
+#endif
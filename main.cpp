@@ -6,6 +6,9 @@
 #include <string> 
 #include "math.h"
 #include "GeoSolver.h"
+#include "Profiler.h"
+#include "GpsConfig.h"
+#include "FixSnapshot.h"
 
 using namespace std;
 using namespace GeoSol;
@@ -27,8 +30,19 @@ AnalogIn pot1(A0);
 AnalogIn pot2(A1);
 
 TinyGPS gpsr;
-GeoFuncs gf;
-Serial serial_gps(D1, D0); //tx,rx
+Solver gf;
+#ifdef GEOSOL_DMA_TRANSPORT
+//characters from GPS are moved by DMA and handed over a sentence batch at a time,
+//not yet run on a K64F, so it has to be chosen explicitly
+DmaTransport gps_link(D1, D0); //tx,rx
+#else
+//characters from GPS are buffered by the receive interrupt
+IrqTransport gps_link(D1, D0); //tx,rx
+#endif
+#ifdef GEOSOL_PROFILE
+//profiler statistics are printed here when 'p' is received
+Serial pc(USBTX, USBRX);
+#endif
 char *joystickPos = "CENTRE";
 char latString[10] = "";
 char lonString[10] = "";
@@ -41,11 +55,37 @@ int menuItemCount = 4;
 //this vector stores number of positions in each menu item
 vector < int > menuPositionCount(menuItemCount);
 
-double lat, lon;
-unsigned long age;
-double potDist, potAngle;
+//potentiometer values, sampled together with each fix
+struct PotReading {
+    double dist, angle;
+};
+
+//last fix and potentiometer values, written by main() and read by the menu thread without locking
+Seqlock < FixSnapshot > gps_fix;
+Seqlock < PotReading > pot_reading;
 bool checked;
 
+//fix older than this counts as lost, the receiver sends several fixes per second
+const uint32_t FIX_TIMEOUT_MS = 2000;
+
+//true when a fix was published within FIX_TIMEOUT_MS
+bool fixCurrent(const FixSnapshot &fix) {
+    return fix.valid && fix.age(us_ticker_read()) < FIX_TIMEOUT_MS;
+}
+
+//print coordinates of the fix into line, or tell that there is none
+void printFix(char *line, const FixSnapshot &fix) {
+    if (!fixCurrent(fix)) {
+        sprintf(line, "no GPS fix");
+        return;
+    }
+    sprintf(latString, "%f", fix.lat);
+    sprintf(lonString, "%f", fix.lon);
+    strcpy(line, latString);
+    strcat(line, "  ");
+    strcat(line, lonString);
+}
+
 //structure, which keeps all the values (both input and output) for all the problems
 struct problem {
     double p1Lat, p1Lon, p2Lat, p2Lon, p3Lat, p3Lon;
@@ -58,58 +98,69 @@ struct problem {
 
 //this procedure allows us to change input data live
 void updateValue() {
+    PROFILE_SCOPE(PROBE_UPDATE_VALUE);
+    FixSnapshot fix = gps_fix.read();
+    PotReading pot = pot_reading.read();
+    //a lost fix leaves the points as they were
+    bool current = fixCurrent(fix);
     
     //updating of Inverse GP parameters
-    if (menuItem == 1 && menuPosition == 1) {
-        GP[0].p1Lat = lat;
-        GP[0].p1Lon = lon;
-    } else if (menuItem == 1 && menuPosition == 2) {
-        GP[0].p2Lat = lat;
-        GP[0].p2Lon = lon;
+    if (menuItem == 1 && menuPosition == 1 && current) {
+        GP[0].p1Lat = fix.lat;
+        GP[0].p1Lon = fix.lon;
+    } else if (menuItem == 1 && menuPosition == 2 && current) {
+        GP[0].p2Lat = fix.lat;
+        GP[0].p2Lon = fix.lon;
     }
 
     //updating of Direct GP parameters
-    else if (menuItem == 2 && menuPosition == 1) {
-        GP[1].p1Lat = lat;
-        GP[1].p1Lon = lon;
+    else if (menuItem == 2 && menuPosition == 1 && current) {
+        GP[1].p1Lat = fix.lat;
+        GP[1].p1Lon = fix.lon;
     } else if (menuItem == 2 && menuPosition == 2) {
-        GP[1].dist = potDist;
+        GP[1].dist = pot.dist;
     } else if (menuItem == 2 && menuPosition == 3) {
-        GP[1].angle = potAngle;
+        GP[1].angle = pot.angle;
     }
 
     //updating of Polar serif problem parameters
-    else if (menuItem == 3 && menuPosition == 1) {
-        GP[2].p1Lat = lat;
-        GP[2].p1Lon = lon;
-    } else if (menuItem == 3 && menuPosition == 2) {
-        GP[2].p2Lat = lat;
-        GP[2].p2Lon = lon;
+    else if (menuItem == 3 && menuPosition == 1 && current) {
+        GP[2].p1Lat = fix.lat;
+        GP[2].p1Lon = fix.lon;
+    } else if (menuItem == 3 && menuPosition == 2 && current) {
+        GP[2].p2Lat = fix.lat;
+        GP[2].p2Lon = fix.lon;
     } else if (menuItem == 3 && menuPosition == 3) {
-        GP[2].dist = potDist;
+        GP[2].dist = pot.dist;
     } else if (menuItem == 3 && menuPosition == 4) {
-        GP[2].angle = potAngle;
+        GP[2].angle = pot.angle;
     }
 
     // Recalculate specific problem if entered parameters are enough for solution
     // Here all the magic happens
     if (menuItem == 1 && (GP[0].p1Lat != 0 || GP[0].p1Lon != 0) && (GP[0].p2Lat != 0 || GP[0].p2Lon != 0)) {
         
+        PROFILE_SCOPE(PROBE_INVERSE);
         GP[0].solved = true;
-        GP[0].dist = gf.inverseDistanceGP(GP[0].p1Lat, GP[0].p1Lon, GP[0].p2Lat, GP[0].p2Lon);
-        GP[0].angle = gf.inverseAzimuthGP(GP[0].p1Lat, GP[0].p1Lon, GP[0].p2Lat, GP[0].p2Lon);
+        InverseResult inv = gf.inverse(GP[0].p1Lat, GP[0].p1Lon, GP[0].p2Lat, GP[0].p2Lon);
+        GP[0].dist = inv.dist;
+        GP[0].angle = inv.azimuth;
         
     } else if (menuItem == 2 && (GP[1].p1Lat != 0 || GP[1].p1Lon != 0)) {
         
+        PROFILE_SCOPE(PROBE_DIRECT);
         GP[1].solved = true;
-        GP[1].p2Lat = gf.directLatGP(GP[1].p1Lat, GP[1].p1Lon, GP[1].angle, GP[1].dist);
-        GP[1].p2Lon = gf.directLonGP(GP[1].p1Lat, GP[1].p1Lon, GP[1].angle, GP[1].dist);
+        DirectResult dir = gf.direct(GP[1].p1Lat, GP[1].p1Lon, GP[1].angle, GP[1].dist);
+        GP[1].p2Lat = dir.lat;
+        GP[1].p2Lon = dir.lon;
     
     } else if (menuItem == 3 && (GP[2].p1Lat != 0 || GP[2].p1Lon != 0) && (GP[2].p2Lat != 0 || GP[2].p2Lon != 0)) {
         
+        PROFILE_SCOPE(PROBE_POLAR);
         GP[2].solved = true;
-        GP[2].p3Lat = gf.polarLatGP(GP[2].p1Lat, GP[2].p1Lon, GP[2].p2Lat, GP[2].p2Lon, GP[2].angle, GP[2].dist);
-        GP[2].p3Lon = gf.polarLonGP(GP[2].p1Lat, GP[2].p1Lon, GP[2].p2Lat, GP[2].p2Lon, GP[2].angle, GP[2].dist);
+        DirectResult pol = gf.polar(GP[2].p1Lat, GP[2].p1Lon, GP[2].p2Lat, GP[2].p2Lon, GP[2].angle, GP[2].dist);
+        GP[2].p3Lat = pol.lat;
+        GP[2].p3Lon = pol.lon;
     }
 }
 
@@ -120,6 +171,8 @@ void printMenu(int menuItem, int menuPosition) {
     static char last_line1[30] = "", last_line2[30] = "", last_line3[30] = ""; 
     char line1[30] = "", line2[30] = "", line3[30] = ""; 
     // otherwise display will blink each second on update
+    FixSnapshot fix = gps_fix.read();
+    PotReading pot = pot_reading.read();
     
     switch (menuItem) {
     //Instruction set
@@ -143,11 +196,7 @@ void printMenu(int menuItem, int menuPosition) {
         case 3:
             sprintf(line1, "Device will turn off LED when");
             sprintf(line2, "GPS satellites will be found");
-            sprintf(latString, "%f", lat);
-            sprintf(lonString, "%f", lon);
-            strcpy(line3, latString);
-            strcat(line3, "  ");
-            strcat(line3, lonString);
+            printFix(line3, fix);
             break;
         case 4:
             sprintf(line1, "To solve geodetic problems");
@@ -179,11 +228,7 @@ void printMenu(int menuItem, int menuPosition) {
                 strcat(line3, lonString);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(latString, "%f", lat);
-                sprintf(lonString, "%f", lon);
-                strcpy(line3, latString);
-                strcat(line3, "  ");
-                strcat(line3, lonString);
+                printFix(line3, fix);
             }
             break;
 
@@ -199,11 +244,7 @@ void printMenu(int menuItem, int menuPosition) {
                 strcat(line3, lonString);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(latString, "%f", lat);
-                sprintf(lonString, "%f", lon);
-                strcpy(line3, latString);
-                strcat(line3, "  ");
-                strcat(line3, lonString);
+                printFix(line3, fix);
             }
             break;
 
@@ -245,11 +286,7 @@ void printMenu(int menuItem, int menuPosition) {
                 strcat(line3, lonString);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(latString, "%f", lat);
-                sprintf(lonString, "%f", lon);
-                strcpy(line3, latString);
-                strcat(line3, "  ");
-                strcat(line3, lonString);
+                printFix(line3, fix);
             }
             break;
 
@@ -261,7 +298,7 @@ void printMenu(int menuItem, int menuPosition) {
                 sprintf(line3, "%0.3f", GP[menuItem - 1].dist);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(line3, "%0.3f", potDist);
+                sprintf(line3, "%0.3f", pot.dist);
             }
             break;
 
@@ -273,7 +310,7 @@ void printMenu(int menuItem, int menuPosition) {
                 sprintf(line3, "%0.3f", GP[menuItem - 1].angle);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(line3, "%0.3f", potAngle);
+                sprintf(line3, "%0.3f", pot.angle);
             }
             break;
 
@@ -311,11 +348,7 @@ void printMenu(int menuItem, int menuPosition) {
                 strcat(line3, lonString);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(latString, "%f", lat);
-                sprintf(lonString, "%f", lon);
-                strcpy(line3, latString);
-                strcat(line3, "  ");
-                strcat(line3, lonString);
+                printFix(line3, fix);
             }
             break;
 
@@ -331,11 +364,7 @@ void printMenu(int menuItem, int menuPosition) {
                 strcat(line3, lonString);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(latString, "%f", lat);
-                sprintf(lonString, "%f", lon);
-                strcpy(line3, latString);
-                strcat(line3, "  ");
-                strcat(line3, lonString);
+                printFix(line3, fix);
             }
             break;
 
@@ -347,7 +376,7 @@ void printMenu(int menuItem, int menuPosition) {
                 sprintf(line3, "%0.3f", GP[menuItem - 1].dist);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(line3, "%0.3f", potDist);
+                sprintf(line3, "%0.3f", pot.dist);
             }
             break;
 
@@ -359,7 +388,7 @@ void printMenu(int menuItem, int menuPosition) {
                 sprintf(line3, "%0.3f", GP[menuItem - 1].angle);
             } else {
                 sprintf(line2, "Click to save parameter");
-                sprintf(line3, "%0.3f", potAngle);
+                sprintf(line3, "%0.3f", pot.angle);
             }
             break;
 
@@ -380,6 +409,8 @@ void printMenu(int menuItem, int menuPosition) {
     //otherwise display blinks each 100 milliseconds
     if (strcmp(line1, last_line1) != 0 || strcmp(line2, last_line2) != 0 || strcmp(line3, last_line3) != 0)
     {
+        //draw all three lines into the frame buffer and send the changes to the display once
+        FrameGuard frame(lcd);
         lcd.cls();
         lcd.locate(0, 0);
         lcd.printf(line1);
@@ -451,6 +482,13 @@ void menu_loop(void const * args) {
     }
 }
 
+#ifdef GEOSOL_PROFILE
+//sends one line of profiler statistics to the PC
+void pcWrite(const char* line) {
+    pc.puts(line);
+}
+#endif
+
 //procedure to turn off LED
 //LED is connected in reversed state, so 1 means off
 void ledOff() {
@@ -496,26 +534,57 @@ int main() {
     lcd.locate(32, 12);
     lcd.printf("GeoSol device");
     
+#ifdef GEOSOL_PROFILE
+    Profiler::init();
+#endif
+
     //set serial connection speed for GPS module
-    serial_gps.baud(9600);
+    gps_link.baud(9600);
     wait(1.0);
+    //switch the receiver to 115200 baud and 10 fixes per second with only the sentences we parse,
+    //on failure the link stays where the receiver still answers
+    GpsConfig gps_config(gps_link, 9600);
+    gps_config.configure(115200, 10);
+    //the menu thread only draws into the frame buffer, a low priority thread sends the frames to the display
+    //so joystick polling doesn't wait for SPI
+    lcd.start_render_thread(osPriorityLow);
     //run the subthread for menu displaying  
     Thread menu_thread(menu_loop);
     
+    //characters received from GPS since the last parse
+    uint8_t gps_buf[64];
+    size_t gps_len;
+    
     //continious update of gps and potentiometers input
     while (true) {
-        if (serial_gps.readable()) {
-            char c = serial_gps.getc();
-            bool gps_available = gpsr.encode(c);
+#ifdef GEOSOL_PROFILE
+        if (pc.readable() && pc.getc() == 'p')
+            Profiler::dump(pcWrite);
+#endif
+        //sleep until the transport hands over a burst, at the latest after 100 ms, then parse what it holds in one pass
+        gps_len = gps_link.read(gps_buf, sizeof(gps_buf), 100);
+        if (gps_len > 0) {
+            bool gps_available = gpsr.encode((const char *)gps_buf, gps_len) > 0;
             if (gps_available) {
                 ledOff();
-                (void) gpsr.f_get_position( & lat, & lon, & age);
+                //gather the whole fix first, the menu thread sees it only once it is complete
+                FixSnapshot fix;
+                gpsr.f_get_position( & fix.lat, & fix.lon);
+                gpsr.get_datetime( & fix.date, & fix.time);
+                fix.hdop = gpsr.hdop();
+                fix.satellites = gpsr.sat_count();
+                fix.valid = true;
+                //TinyGPS has no clock of its own, readers age the fix from the time it was published
+                fix.stamp = us_ticker_read();
+                gps_fix.write(fix);
+                PotReading pot;
                 int ip, fp;
                 ip = (int)(pot1 * 100);
                 fp = (int)(pot2 * 1000);
-                potDist = ip + fp * 0.001;
+                pot.dist = ip + fp * 0.001;
                 ip = (int)(pot1 * 360);
-                potAngle = ip + fp * 0.001;
+                pot.angle = ip + fp * 0.001;
+                pot_reading.write(pot);
             }
         }
     }
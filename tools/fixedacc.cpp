@@ -0,0 +1,120 @@
+// fixedacc.cpp
+//host tool to check accuracy of GeoFixed integer kernels against the double precision GeoFuncs solver
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -I../libraries/GeoSolver fixedacc.cpp ../libraries/GeoSolver/GeoFixed.cpp ../libraries/GeoSolver/GeoSolver.cpp ../libraries/GeoSolver/GeoTrig.cpp -o fixedacc
+//usage:
+//  fixedacc [points per band]
+//
+//for every band of distances random lines within +-85 degrees of latitude, with lengths from half the band
+//to the band, are solved by both solvers on the same coordinates in ten millionths of a degree.
+//Errors are printed in millimetres: distance error and lateral error of azimuth for inverseHR, position
+//error for directHR, which includes rounding of the result to 0.0000001 degree.
+//Every band is checked against the bounds documented in GeoFixed.h, and lines beyond MAX_BASELINE
+//must come back invalid; the exit status is 1 when any check failed
+
+#include "GeoFixed.h"
+#include "GeoSolver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace GeoSol;
+
+//longest line of a band, km, and documented bounds of its errors, mm
+struct Band {
+    double maxDist, dist, lateral, position;
+};
+
+static const Band BANDS[] = {
+    {0.1, 1, 0.1, 8},
+    {1, 1, 0.2, 8},
+    {10, 1.5, 1.5, 8},
+    {50, 5, 8, 10},
+    {100, 40, 55, 60},
+};
+
+static int failures;
+
+static void check(const char* name, bool pass) {
+    printf("%-48s %s\n", name, pass ? "PASS" : "FAIL");
+    if (!pass)
+        failures++;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+static double e7(int32_t v) {
+    return v * 1e-7;
+}
+
+//angle between two azimuths in radians
+static double azimuthDiff(double az1, double az2) {
+    return GeoFuncs::deg2rad(remainder(az1 - az2, 360.0));
+}
+
+static void measure(const Band &band, long points) {
+    double dist = 0, lateral = 0, position = 0, lat, lon, angle, d, e;
+    char name[64];
+    long i;
+
+    srand(1);
+    for (i = 0; i < points; i++) {
+        lat = uniform(-85, 85);
+        lon = uniform(-180, 180);
+        angle = uniform(0, 360);
+        d = uniform(band.maxDist / 2, band.maxDist);
+        DirectResult end = GeoFuncs::direct(lat, lon, angle, d);
+        if (fabs(end.lat) > 85) {
+            i--;
+            continue;
+        }
+
+        //inverse on coordinates rounded to ten millionths of a degree
+        int32_t lat1 = (int32_t)lrint(lat * 1e7), lon1 = (int32_t)lrint(lon * 1e7);
+        int32_t lat2 = (int32_t)lrint(end.lat * 1e7), lon2 = (int32_t)lrint(end.lon * 1e7);
+        InverseResult ref = GeoFuncs::inverse(e7(lat1), e7(lon1), e7(lat2), e7(lon2));
+        FixedInverse inv = GeoFixed::inverseHR(lat1, lon1, lat2, lon2);
+        e = fabs(inv.dist - ref.dist * 1e6);
+        dist = e > dist ? e : dist;
+        e = fabs(azimuthDiff(inv.azimuth * 1e-5, ref.azimuth)) * ref.dist * 1e6;
+        lateral = e > lateral ? e : lateral;
+
+        //direct with distance in mm and azimuth in hundred thousandths of a degree
+        long mm = lrint(d * 1e6), az = lrint(angle * 1e5);
+        DirectResult refDir = GeoFuncs::direct(e7(lat1), e7(lon1), az * 1e-5, mm * 1e-6);
+        FixedDirect dir = GeoFixed::directHR(lat1, lon1, az, mm);
+        e = GeoFuncs::inverse(refDir.lat, refDir.lon, e7(dir.lat), e7(dir.lon)).dist * 1e6;
+        position = e > position ? e : position;
+    }
+    printf("%8.1f km %12.4f %12.4f %12.4f\n", band.maxDist, dist, lateral, position);
+    snprintf(name, sizeof(name), "bounds up to %g km", band.maxDist);
+    check(name, dist < band.dist && lateral < band.lateral && position < band.position);
+}
+
+int main(int argc, char** argv) {
+    long points = argc > 1 ? atol(argv[1]) : 100000;
+
+    printf("%11s %12s %12s %12s\n", "max", "dist mm", "lateral mm", "position mm");
+    for (size_t i = 0; i < sizeof(BANDS) / sizeof(BANDS[0]); i++)
+        measure(BANDS[i], points);
+
+    //lines beyond MAX_BASELINE: a few km over it, across the globe and across the antimeridian
+    DirectResult over = GeoFuncs::direct(47.5, 19.05, 30, GeoFixed::MAX_BASELINE * 1e-6 + 5);
+    DirectResult under = GeoFuncs::direct(47.5, 19.05, 30, GeoFixed::MAX_BASELINE * 1e-6 - 5);
+    check("inverse just below MAX_BASELINE valid", GeoFixed::inverseHR(475000000, 190500000,
+        (int32_t)lrint(under.lat * 1e7), (int32_t)lrint(under.lon * 1e7)).valid);
+    check("inverse just above MAX_BASELINE invalid", !GeoFixed::inverseHR(475000000, 190500000,
+        (int32_t)lrint(over.lat * 1e7), (int32_t)lrint(over.lon * 1e7)).valid);
+    check("inverse across the globe invalid", !GeoFixed::inverseHR(475000000, 190500000, -475000000, -1609500000).valid);
+    check("inverse at 80 degrees invalid", !GeoFixed::inverseHR(800000000, 0, 800000000, 100000000).valid);
+    check("inverse over antimeridian valid", GeoFixed::inverseHR(0, 1799000000, 0, -1799000000).valid);
+    check("raw inverse of 2500 km invalid", !GeoFixed::inverse(0, 0, 0, 2250000).valid);
+    check("direct above MAX_BASELINE invalid", !GeoFixed::directHR(0, 0, 0, GeoFixed::MAX_BASELINE + 1).valid);
+    check("direct of negative distance invalid", !GeoFixed::directHR(0, 0, 0, -1).valid);
+    check("direct of MAX_BASELINE valid", GeoFixed::directHR(0, 0, 0, GeoFixed::MAX_BASELINE).valid);
+    check("polar from 2500 km line invalid", !GeoFixed::polar(0, 0, 0, 2250000, 0, 1000).valid);
+    return failures ? 1 : 0;
+}
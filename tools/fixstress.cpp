@@ -0,0 +1,98 @@
+// fixstress.cpp
+//host stress test of Seqlock: a writer thread publishes fixes like the GPS loop, reader threads check every copy
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -pthread -DGEOSOL_HOST -I../libraries/GpsLink fixstress.cpp -o fixstress
+//usage:
+//  fixstress [seconds] [readers]
+//
+//every field of fix number k is derived from k, so a copy mixing two fixes is caught by any reader.
+//a run passes when no reader saw a torn fix and every reader saw the fixes in publication order,
+//and FixSnapshot::age() is right across a wrap of the microsecond clock
+
+#include "FixSnapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace GeoSol;
+
+static Seqlock<FixSnapshot> published;
+static std::atomic<bool> running(true);
+
+static FixSnapshot make(unsigned long k) {
+    FixSnapshot fix;
+    fix.lat = 48.0 + k * 1e-7;
+    fix.lon = 11.0 - k * 1e-7;
+    fix.date = k;
+    fix.time = k * 7;
+    fix.hdop = k ^ 0x5555;
+    fix.satellites = (unsigned short)k;
+    fix.stamp = (uint32_t)~k;
+    fix.valid = true;
+    return fix;
+}
+
+static bool consistent(const FixSnapshot &fix) {
+    FixSnapshot expected;
+    if (!fix.valid)
+        return fix.date == 0;
+    expected = make(fix.date);
+    return fix.lat == expected.lat && fix.lon == expected.lon && fix.time == expected.time &&
+        fix.hdop == expected.hdop && fix.satellites == expected.satellites && fix.stamp == expected.stamp;
+}
+
+struct ReaderResult {
+    unsigned long reads, torn, reordered;
+};
+
+static void reader(ReaderResult* result) {
+    unsigned long last = 0;
+    FixSnapshot fix;
+    while (running) {
+        fix = published.read();
+        result->reads++;
+        if (!consistent(fix))
+            result->torn++;
+        else if (fix.date < last)
+            result->reordered++;
+        else
+            last = fix.date;
+    }
+}
+
+int main(int argc, char** argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 2;
+    int readers = argc > 2 ? atoi(argv[2]) : 3;
+    std::vector<ReaderResult> results(readers, ReaderResult());
+    std::vector<std::thread> threads;
+    unsigned long k = 0, reads = 0, torn = 0, reordered = 0;
+    bool pass;
+
+    for (int i = 0; i < readers; i++)
+        threads.push_back(std::thread(reader, &results[i]));
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end)
+        published.write(make(++k));
+    running = false;
+    for (int i = 0; i < readers; i++) {
+        threads[i].join();
+        reads += results[i].reads;
+        torn += results[i].torn;
+        reordered += results[i].reordered;
+    }
+
+    pass = torn == 0 && reordered == 0 && published.generation() == (uint32_t)k;
+    printf("%lu fixes published, %lu reads by %d readers, %lu torn, %lu out of order: %s\n",
+        k, reads, readers, torn, reordered, pass ? "PASS" : "FAIL");
+
+    //age of a fix published 8 ms before the microsecond clock wrapped, read 8 ms after
+    FixSnapshot fix = make(1);
+    fix.stamp = 0xFFFFFFFFUL - 7999;
+    bool aged = fix.age(8000) == 16;
+    printf("age across wrap of the clock: %s\n", aged ? "PASS" : "FAIL");
+    return pass && aged ? 0 : 1;
+}
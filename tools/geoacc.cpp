@@ -0,0 +1,126 @@
+// geoacc.cpp
+//host tool to measure accuracy of GeoFuncsT kernels against the double precision GeoFuncs solver
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -I../libraries/GeoSolver geoacc.cpp ../libraries/GeoSolver/GeoSolver.cpp ../libraries/GeoSolver/GeoTrig.cpp -o geoacc
+//add -DGEOSOL_TRIG_TABLES to measure float kernels running on GeoTrig lookup tables
+//usage:
+//  geoacc [points per band]
+//
+//for every band of distances random lines are solved by both solvers, errors are printed in centimetres:
+//distance error and lateral error of azimuth for inverse problem, position error for direct problem.
+//before that GeoFuncs::inverse is checked against reference lines solved by GeographicLib, among them
+//near-antipodal points on the equator; the exit status is 1 when any of them is off
+
+#include "GeoSolver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace GeoSol;
+
+//accumulated maximum and root mean square of errors
+struct ErrorStats {
+    double max, sum2;
+    long count;
+};
+
+static void add(ErrorStats &st, double err) {
+    err = fabs(err);
+    if (err > st.max)
+        st.max = err;
+    st.sum2 += err * err;
+    st.count++;
+}
+
+static double rms(const ErrorStats &st) {
+    return st.count ? sqrt(st.sum2 / st.count) : 0;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+//angle between two azimuths in radians
+static double azimuthDiff(double az1, double az2) {
+    double d = fmod(az1 - az2, 360.0);
+    if (d > 180) d -= 360;
+    if (d < -180) d += 360;
+    return GeoFuncs::deg2rad(d);
+}
+
+//line with distance (km) and azimuths (degrees) from GeographicLib
+struct Reference {
+    double p1Lat, p1Lon, p2Lat, p2Lon, dist, azimuth, backAzimuth;
+};
+
+static const Reference REFERENCES[] = {
+    {0, 0, 0, 179.5, 19980.861908891, 55.966495140, -55.966495140},
+    {0, 0, 0, -179.5, 19980.861908891, -55.966495140, 55.966495140},
+    {0, 10, 0, -170.2, 20000.239437725, 19.368626539, -19.368626539},
+    {0, 0, 0, 180, 20003.931458625, 0.000000000, 0.000000000},
+    {0, 0, 0.5, 179.7, 19944.127420750, 15.556882793, -15.557486109},
+    {40.6, -73.8, 51.6, -0.5, 5551.759400319, 51.198882846, -72.178223264},
+};
+
+//limits of distance error (cm) and azimuth error (degrees), azimuths of near-antipodal lines
+//are sensitive and a lateral error in centimetres would mean little
+static const double REFERENCE_DIST = 0.1;
+static const double REFERENCE_AZIMUTH = 1e-6;
+
+static int checkReferences() {
+    int failures = 0;
+
+    printf("%-32s %10s %10s %10s %s\n", "reference line", "dist cm", "az deg", "back deg", "");
+    for (size_t i = 0; i < sizeof(REFERENCES) / sizeof(REFERENCES[0]); i++) {
+        const Reference &r = REFERENCES[i];
+        InverseResult inv = GeoFuncs::inverse(r.p1Lat, r.p1Lon, r.p2Lat, r.p2Lon);
+        double dist = (inv.dist - r.dist) * 1e5;
+        double az = GeoFuncs::rad2deg(azimuthDiff(inv.azimuth, r.azimuth));
+        double back = GeoFuncs::rad2deg(azimuthDiff(inv.backAzimuth, r.backAzimuth));
+        bool pass = fabs(dist) < REFERENCE_DIST && fabs(az) < REFERENCE_AZIMUTH && fabs(back) < REFERENCE_AZIMUTH;
+        char name[64];
+
+        snprintf(name, sizeof(name), "(%g, %g) - (%g, %g)", r.p1Lat, r.p1Lon, r.p2Lat, r.p2Lon);
+        printf("%-32s %10.4f %10.2e %10.2e %s\n", name, dist, az, back, pass ? "PASS" : "FAIL");
+        if (!pass)
+            failures++;
+    }
+    printf("\n");
+    return failures;
+}
+
+template <typename T>
+static void measure(const char* name, double maxDist, long points) {
+    ErrorStats dist = {0, 0, 0}, az = {0, 0, 0}, back = {0, 0, 0}, pos = {0, 0, 0};
+    srand(1);
+    for (long i = 0; i < points; i++) {
+        double lat = uniform(-85, 85), lon = uniform(-180, 180), angle = uniform(0, 360), d = uniform(0, maxDist);
+        DirectResult ref = GeoFuncs::direct(lat, lon, angle, d);
+        InverseResult refInv = GeoFuncs::inverse(lat, lon, ref.lat, ref.lon);
+        InverseResult inv = GeoFuncsT<T>::inverse(lat, lon, ref.lat, ref.lon);
+        DirectResult dir = GeoFuncsT<T>::direct(lat, lon, angle, d);
+
+        //km to cm
+        add(dist, (inv.dist - refInv.dist) * 1e5);
+        add(az, azimuthDiff(inv.azimuth, refInv.azimuth) * refInv.dist * 1e5);
+        add(back, azimuthDiff(inv.backAzimuth, refInv.backAzimuth) * refInv.dist * 1e5);
+        add(pos, GeoFuncs::inverse(ref.lat, ref.lon, dir.lat, dir.lon).dist * 1e5);
+    }
+    printf("%-8s %8.1f %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f\n", name, maxDist,
+        dist.max, rms(dist), az.max, rms(az), back.max, rms(back), pos.max, rms(pos));
+}
+
+int main(int argc, char** argv) {
+    static const double bands[] = {0.1, 1, 10, 50};
+    long points = argc > 1 ? atol(argv[1]) : 100000;
+    int failures = checkReferences();
+
+    printf("%-8s %8s %10s %10s %10s %10s %10s %10s %10s %10s\n", "kernel", "max km",
+        "dist max", "dist rms", "az max", "az rms", "back max", "back rms", "pos max", "pos rms");
+    for (size_t i = 0; i < sizeof(bands) / sizeof(bands[0]); i++) {
+        measure<float>("float", bands[i], points);
+        measure<double>("double", bands[i], points);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+// geobench.cpp
+//host microbenchmark of GeoFuncs, GeoFuncsT<float>, GeoFixed and GeoTrig, results are printed as JSON
+//so that runs can be compared between releases
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -I../libraries/GeoSolver geobench.cpp ../libraries/GeoSolver/GeoSolver.cpp ../libraries/GeoSolver/GeoTrig.cpp ../libraries/GeoSolver/GeoFixed.cpp -o geobench
+//build with -O3 -fno-math-errno instead to let GCC vectorize the iteration of GeoFuncs::inverseGP,
+//add -DGEOSOL_TRIG_TABLES to time GeoFuncsT<float> on GeoTrig instead of sinf, cosf and atan2f
+//usage:
+//  geobench [minimum milliseconds per measurement] > bench.json
+//
+//every GeoFuncs entry point, directDistance and directAngle on the plane included, runs over fixed sets
+//of lines: short, long, equatorial, near-antipodal and one line,
+//the last being points staked out along a single line from one start point.
+//ns_per_op is wall time per solved line; iterations are taken from GeoFuncs::inverse() for the same lines
+//and are null for entry points that do not run the inverse solver.
+//GeoTrig functions are timed next to sinf, cosf and atan2f on the azimuths and coordinate differences
+//of the same lines. GeoFixed runs only on cases whose lines are all within GeoFixed::MAX_BASELINE
+
+#include "GeoSolver.h"
+#include "GeoFixed.h"
+#include "GeoTrig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+using namespace GeoSol;
+
+static const int LINES = 256;
+
+//lines of one case, angle and dist are the azimuth and length of the line from p1 to p2
+struct Case {
+    const char* name;
+    double p1Lat[LINES], p1Lon[LINES], p2Lat[LINES], p2Lon[LINES], angle[LINES], dist[LINES];
+
+    //same lines for GeoFixed, coordinates in ten millionths of a degree, azimuth in hundred thousandths
+    //of a degree and length in mm; fixed is false if a line is longer than GeoFixed::MAX_BASELINE
+    int32_t p1LatE7[LINES], p1LonE7[LINES], p2LatE7[LINES], p2LonE7[LINES];
+    long angleE5[LINES], distMm[LINES];
+    bool fixed;
+
+    //arguments of GeoTrig and libm functions, azimuth in radians and coordinate differences in degrees
+    float angleRad[LINES], dLat[LINES], dLon[LINES];
+};
+
+//keeps results alive so that the compiler cannot drop the calls
+static volatile double sink;
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+static double wrap(double lon) {
+    return lon > 180 ? lon - 360 : lon;
+}
+
+//fill second point from direct problem, lines of random azimuth with length in [minDist, maxDist] km
+static void directCase(Case &c, const char* name, double minDist, double maxDist) {
+    c.name = name;
+    for (int i = 0; i < LINES; i++) {
+        c.p1Lat[i] = uniform(-80, 80);
+        c.p1Lon[i] = uniform(-180, 180);
+        c.angle[i] = uniform(-180, 180);
+        c.dist[i] = uniform(minDist, maxDist);
+        DirectResult p2 = GeoFuncs::direct(c.p1Lat[i], c.p1Lon[i], c.angle[i], c.dist[i]);
+        c.p2Lat[i] = p2.lat;
+        c.p2Lon[i] = p2.lon;
+    }
+}
+
+//fill azimuth and length from inverse problem for given point pairs
+static void inverseCase(Case &c) {
+    for (int i = 0; i < LINES; i++) {
+        InverseResult inv = GeoFuncs::inverse(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i]);
+        c.angle[i] = inv.azimuth;
+        c.dist[i] = inv.dist;
+    }
+}
+
+static void equatorialCase(Case &c) {
+    c.name = "equatorial";
+    for (int i = 0; i < LINES; i++) {
+        c.p1Lat[i] = c.p2Lat[i] = 0;
+        c.p1Lon[i] = uniform(-180, 180);
+        c.p2Lon[i] = wrap(c.p1Lon[i] + uniform(1, 179.5));
+    }
+    inverseCase(c);
+}
+
+//second point within half a degree of the antipode of the first one
+static void antipodalCase(Case &c) {
+    c.name = "near-antipodal";
+    for (int i = 0; i < LINES; i++) {
+        c.p1Lat[i] = uniform(-60, 60);
+        c.p1Lon[i] = uniform(-180, 180);
+        c.p2Lat[i] = -c.p1Lat[i] + uniform(-0.5, 0.5);
+        c.p2Lon[i] = wrap(c.p1Lon[i] + 180 + uniform(-0.5, 0.5));
+    }
+    inverseCase(c);
+}
+
+//points along one line from a single start point, as staked out from a base station
+static void oneLineCase(Case &c) {
+    c.name = "one line";
+    for (int i = 0; i < LINES; i++) {
+        c.p1Lat[i] = 47.5;
+        c.p1Lon[i] = 19.05;
+        c.angle[i] = 62.5;
+        c.dist[i] = 0.05 * (i + 1);
+        DirectResult p2 = GeoFuncs::direct(c.p1Lat[i], c.p1Lon[i], c.angle[i], c.dist[i]);
+        c.p2Lat[i] = p2.lat;
+        c.p2Lon[i] = p2.lon;
+    }
+}
+
+//fill the GeoFixed and trigonometry arguments from the lines of the case
+static void derivedArgs(Case &c) {
+    c.fixed = true;
+    for (int i = 0; i < LINES; i++) {
+        c.p1LatE7[i] = (int32_t)lround(c.p1Lat[i] * 1e7);
+        c.p1LonE7[i] = (int32_t)lround(c.p1Lon[i] * 1e7);
+        c.p2LatE7[i] = (int32_t)lround(c.p2Lat[i] * 1e7);
+        c.p2LonE7[i] = (int32_t)lround(c.p2Lon[i] * 1e7);
+        c.angleE5[i] = lround((c.angle[i] < 0 ? c.angle[i] + 360 : c.angle[i]) * 1e5) % 36000000;
+        c.distMm[i] = lround(c.dist[i] * 1e6);
+        if (c.dist[i] * 1e6 > GeoFixed::MAX_BASELINE)
+            c.fixed = false;
+        c.angleRad[i] = (float)GeoFuncs::deg2rad(c.angle[i]);
+        c.dLat[i] = (float)(c.p2Lat[i] - c.p1Lat[i]);
+        c.dLon[i] = (float)(c.p2Lon[i] - c.p1Lon[i]);
+    }
+}
+
+//run fn over all lines of the case, doubling repetitions until the run lasts at least minMs
+template <typename F>
+static double nsPerOp(F fn, const Case &c, double minMs) {
+    long reps = 1, r;
+    int i;
+    double acc, ns;
+
+    for (;;) {
+        acc = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (r = 0; r < reps; r++)
+            for (i = 0; i < LINES; i++)
+                acc += fn(c, i);
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sink = acc;
+        if (ns >= minMs * 1e6)
+            return ns / ((double)reps * LINES);
+        reps *= 2;
+    }
+}
+
+//inverse solver iterations for the lines of the case
+static void iterations(const Case &c, double &mean, int &max) {
+    long sum = 0;
+    max = 0;
+    for (int i = 0; i < LINES; i++) {
+        int n = GeoFuncs::inverse(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i]).iterations;
+        sum += n;
+        if (n > max)
+            max = n;
+    }
+    mean = (double)sum / LINES;
+}
+
+static bool first = true;
+
+template <typename F>
+static void report(const char* function, F fn, const Case &c, double minMs, bool solvesInverse) {
+    double ns = nsPerOp(fn, c, minMs), mean;
+    int max;
+
+    printf("%s    {\"function\": \"%s\", \"case\": \"%s\", \"ns_per_op\": %.1f, ", first ? "" : ",\n", function, c.name, ns);
+    if (solvesInverse) {
+        iterations(c, mean, max);
+        printf("\"iterations_mean\": %.2f, \"iterations_max\": %d}", mean, max);
+    } else {
+        printf("\"iterations_mean\": null, \"iterations_max\": null}");
+    }
+    first = false;
+}
+
+//batch entry points are timed per line over the whole case
+static double batchInverse(const Case &c, int i) {
+    static double dist[LINES], az[LINES];
+    if (i != 0)
+        return 0;
+    GeoFuncs::inverseGP(c.p1Lat, c.p1Lon, c.p2Lat, c.p2Lon, LINES, dist, az);
+    return dist[LINES - 1];
+}
+
+static double batchDirect(const Case &c, int i) {
+    static double lat[LINES], lon[LINES];
+    if (i != 0)
+        return 0;
+    GeoFuncs::directGP(c.p1Lat, c.p1Lon, c.angle, c.dist, LINES, lat, lon);
+    return lat[LINES - 1];
+}
+
+//polar problem turns by a fixed angle from the line and reuses its length
+static const double POLAR_ANGLE = 30;
+
+//lines of the current case, built before timing so that only GeodesicLine::position() is measured
+static std::vector<GeodesicLine> lines;
+
+static void benchCase(const Case &c, double minMs) {
+    //plane entry points, longitude and latitude stand for x and y
+    report("directDistance", [](const Case &c, int i) {
+        return GeoFuncs::directDistance(c.p1Lon[i], c.p1Lat[i], c.p2Lon[i], c.p2Lat[i]); }, c, minMs, false);
+    report("directAngle", [](const Case &c, int i) {
+        return GeoFuncs::directAngle(c.p1Lon[i], c.p1Lat[i], c.p2Lon[i], c.p2Lat[i]); }, c, minMs, false);
+    report("inverseDistanceGP", [](const Case &c, int i) {
+        return GeoFuncs::inverseDistanceGP(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i]); }, c, minMs, true);
+    report("inverseAzimuthGP", [](const Case &c, int i) {
+        return GeoFuncs::inverseAzimuthGP(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i]); }, c, minMs, true);
+    report("inverse", [](const Case &c, int i) {
+        return GeoFuncs::inverse(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i]).dist; }, c, minMs, true);
+    report("inverseGP[batch]", batchInverse, c, minMs, true);
+    report("directLatGP", [](const Case &c, int i) {
+        return GeoFuncs::directLatGP(c.p1Lat[i], c.p1Lon[i], c.angle[i], c.dist[i]); }, c, minMs, false);
+    report("directLonGP", [](const Case &c, int i) {
+        return GeoFuncs::directLonGP(c.p1Lat[i], c.p1Lon[i], c.angle[i], c.dist[i]); }, c, minMs, false);
+    report("direct", [](const Case &c, int i) {
+        return GeoFuncs::direct(c.p1Lat[i], c.p1Lon[i], c.angle[i], c.dist[i]).lat; }, c, minMs, false);
+    report("directGP[batch]", batchDirect, c, minMs, false);
+    lines.clear();
+    for (int i = 0; i < LINES; i++)
+        lines.push_back(GeodesicLine(c.p1Lat[i], c.p1Lon[i], c.angle[i]));
+    report("GeodesicLine::position", [](const Case &c, int i) {
+        return lines[i].position(c.dist[i]).lat; }, c, minMs, false);
+    report("polarLatGP", [](const Case &c, int i) {
+        return GeoFuncs::polarLatGP(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i], POLAR_ANGLE, c.dist[i]); }, c, minMs, true);
+    report("polarLonGP", [](const Case &c, int i) {
+        return GeoFuncs::polarLonGP(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i], POLAR_ANGLE, c.dist[i]); }, c, minMs, true);
+    report("polar", [](const Case &c, int i) {
+        return GeoFuncs::polar(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i], POLAR_ANGLE, c.dist[i]).lat; }, c, minMs, true);
+
+    //single-precision kernels pass lines longer than SHORT_BASELINE to GeoFuncs
+    report("GeoFuncsT<float>::inverse", [](const Case &c, int i) {
+        return GeoFuncsT<float>::inverse(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i]).dist; }, c, minMs, false);
+    report("GeoFuncsT<float>::direct", [](const Case &c, int i) {
+        return GeoFuncsT<float>::direct(c.p1Lat[i], c.p1Lon[i], c.angle[i], c.dist[i]).lat; }, c, minMs, false);
+    report("GeoFuncsT<float>::polar", [](const Case &c, int i) {
+        return GeoFuncsT<float>::polar(c.p1Lat[i], c.p1Lon[i], c.p2Lat[i], c.p2Lon[i], POLAR_ANGLE, c.dist[i]).lat; }, c, minMs, false);
+
+    if (c.fixed) {
+        report("GeoFixed::inverse", [](const Case &c, int i) {
+            return (double)GeoFixed::inverse(c.p1LatE7[i] / 100, c.p1LonE7[i] / 100, c.p2LatE7[i] / 100, c.p2LonE7[i] / 100).dist; }, c, minMs, false);
+        report("GeoFixed::direct", [](const Case &c, int i) {
+            return (double)GeoFixed::direct(c.p1LatE7[i] / 100, c.p1LonE7[i] / 100, c.angleE5[i], c.distMm[i]).lat; }, c, minMs, false);
+        report("GeoFixed::inverseHR", [](const Case &c, int i) {
+            return (double)GeoFixed::inverseHR(c.p1LatE7[i], c.p1LonE7[i], c.p2LatE7[i], c.p2LonE7[i]).dist; }, c, minMs, false);
+        report("GeoFixed::directHR", [](const Case &c, int i) {
+            return (double)GeoFixed::directHR(c.p1LatE7[i], c.p1LonE7[i], c.angleE5[i], c.distMm[i]).lat; }, c, minMs, false);
+    }
+
+    report("GeoTrig::sin", [](const Case &c, int i) {
+        return (double)GeoTrig::sin(c.angleRad[i]); }, c, minMs, false);
+    report("sinf", [](const Case &c, int i) {
+        return (double)sinf(c.angleRad[i]); }, c, minMs, false);
+    report("GeoTrig::cos", [](const Case &c, int i) {
+        return (double)GeoTrig::cos(c.angleRad[i]); }, c, minMs, false);
+    report("cosf", [](const Case &c, int i) {
+        return (double)cosf(c.angleRad[i]); }, c, minMs, false);
+    report("GeoTrig::atan2", [](const Case &c, int i) {
+        return (double)GeoTrig::atan2(c.dLat[i], c.dLon[i]); }, c, minMs, false);
+    report("atan2f", [](const Case &c, int i) {
+        return (double)atan2f(c.dLat[i], c.dLon[i]); }, c, minMs, false);
+}
+
+int main(int argc, char** argv) {
+    static Case cases[5];
+    double minMs = argc > 1 ? atof(argv[1]) : 50;
+
+    srand(1);
+    directCase(cases[0], "short", 0.1, 10);
+    directCase(cases[1], "long", 5000, 15000);
+    equatorialCase(cases[2]);
+    antipodalCase(cases[3]);
+    oneLineCase(cases[4]);
+    for (int i = 0; i < 5; i++)
+        derivedArgs(cases[i]);
+
+#ifdef GEOSOL_TRIG_TABLES
+    const char* trigTables = "true";
+#else
+    const char* trigTables = "false";
+#endif
+    printf("{\n  \"lines_per_case\": %d,\n  \"min_ms\": %.1f,\n  \"trig_tables\": %s,\n  \"results\": [\n", LINES, minMs, trigTables);
+    for (int i = 0; i < 5; i++)
+        benchCase(cases[i], minMs);
+    printf("\n  ]\n}\n");
+    return 0;
+}
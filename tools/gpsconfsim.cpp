@@ -0,0 +1,284 @@
+// gpsconfsim.cpp
+//host check of GpsConfig against simulated receivers that answer UBX-CFG or PMTK commands
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -DGEOSOL_HOST -I../libraries/GpsLink -I../libraries/UbxDecoder gpsconfsim.cpp ../libraries/GpsLink/GpsConfig.cpp ../libraries/UbxDecoder/UbxDecoder.cpp -o gpsconfsim
+//usage:
+//  gpsconfsim
+//
+//every scenario starts a receiver at its power-on defaults, 9600 baud and 1 Hz with chatty NMEA output,
+//and runs GpsConfig::configure(115200, 10) or with a rate GpsConfig has to refuse. The simulation keeps
+//a clock driven by the bytes on the link, emits NMEA bursts at the receiver rate, and garbles bytes sent
+//while the two sides disagree on baud rate.
+//A scenario passes when both sides end at the same baud rate, the reported state matches the receiver
+//and the selected output fits the link; a refused rate must leave the link untouched
+
+#include "GpsConfig.h"
+#include "UbxDecoder.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <deque>
+
+using namespace GeoSol;
+
+enum Kind { UBLOX, UBLOX_NO_GST, MTK, MTK_FIXED_BAUD, SILENT };
+
+//NMEA output of one fix, in bit order of GpsSentence
+static const char* const SENTENCES[8] = {
+    "GPGGA,123519.00,4807.03800,N,01131.00000,E,1,08,0.9,545.4,M,46.9,M,,",
+    "GPGLL,4807.03800,N,01131.00000,E,123519.00,A,A",
+    "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1",
+    "GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00",
+    "GPRMC,123519.00,A,4807.03800,N,01131.00000,E,0.022,,230394,,,A",
+    "GPVTG,,T,,M,0.022,N,0.041,K,A",
+    "GPGST,123519.00,0.006,0.023,0.020,273.6,0.023,0.020,0.031",
+    "GPZDA,123519.00,23,03,1994,00,00"
+};
+
+//GSV goes out as three sentences per fix
+static const int GSV_MESSAGES = 3;
+
+static std::string sentence(const char* body) {
+    char tail[8];
+    unsigned char sum = 0;
+    for (const char* p = body; *p; p++)
+        sum ^= (unsigned char)*p;
+    snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+    return std::string("$") + body + tail;
+}
+
+class SimReceiver : public GpsTransport {
+public:
+    SimReceiver(Kind kind) : kind(kind), rxBaud(9600), hostBaud(9600), rateHz(1), clockMs(0), nextFixMs(0),
+        garbled(0), lineLen(0), inLine(false) {
+        //power-on output of both families
+        sentences = GPS_OUT_GGA | GPS_OUT_GLL | GPS_OUT_GSA | GPS_OUT_GSV | GPS_OUT_RMC | GPS_OUT_VTG;
+    }
+
+    virtual void write(const uint8_t* buf, size_t len) {
+        advance(len);
+        if (hostBaud != rxBaud) {
+            garbled += len;
+            return;
+        }
+        for (size_t i = 0; i < len; i++)
+            receive(buf[i]);
+    }
+
+    virtual size_t read(uint8_t* buf, size_t len, int timeoutMs) {
+        size_t n = 0;
+        //nothing pending: wait for the next burst or the timeout
+        if (out.empty())
+            advanceMs(nextFixMs - clockMs < timeoutMs ? nextFixMs - clockMs : timeoutMs);
+        while (n < len && !out.empty()) {
+            //bytes sent at another baud rate arrive as noise
+            buf[n++] = out.front().second == hostBaud ? out.front().first : 0xF0;
+            out.pop_front();
+        }
+        advance(n);
+        return n;
+    }
+
+    virtual void baud(int rate) {
+        hostBaud = rate;
+    }
+
+    virtual uint32_t millis() {
+        return (uint32_t)clockMs;
+    }
+
+    //bytes of NMEA output per fix
+    size_t burstBytes() const {
+        size_t n = 0;
+        for (int i = 0; i < 8; i++)
+            if (sentences & (1u << i))
+                n += sentence(SENTENCES[i]).size() * (i == 3 ? GSV_MESSAGES : 1);
+        return n;
+    }
+
+    Kind kind;
+    int rxBaud, hostBaud, rateHz;
+    unsigned sentences;
+    long clockMs, nextFixMs;
+    unsigned long garbled;
+
+private:
+
+    void advance(size_t bytes) {
+        advanceMs((long)(bytes * 10 * 1000 / hostBaud));
+    }
+
+    void advanceMs(long ms) {
+        clockMs += ms;
+        while (nextFixMs <= clockMs) {
+            emitFix();
+            nextFixMs += 1000 / rateHz;
+        }
+    }
+
+    void send(const std::string &s) {
+        for (size_t i = 0; i < s.size(); i++)
+            out.push_back(std::make_pair((uint8_t)s[i], rxBaud));
+    }
+
+    void emitFix() {
+        if (kind == SILENT)
+            return;
+        for (int i = 0; i < 8; i++)
+            if (sentences & (1u << i))
+                for (int k = 0; k < (i == 3 ? GSV_MESSAGES : 1); k++)
+                    send(sentence(SENTENCES[i]));
+    }
+
+    void sendUbx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+        std::string s("\xB5\x62", 2);
+        uint8_t a = 0, b = 0;
+        s += (char)cls;
+        s += (char)id;
+        s += (char)(len & 0xFF);
+        s += (char)(len >> 8);
+        s.append((const char*)payload, len);
+        for (size_t i = 2; i < s.size(); i++) {
+            a += (uint8_t)s[i];
+            b += a;
+        }
+        s += (char)a;
+        s += (char)b;
+        send(s);
+    }
+
+    void ack(bool ok, uint8_t cls, uint8_t id) {
+        uint8_t payload[2] = { cls, id };
+        sendUbx(0x05, ok ? 0x01 : 0x00, payload, 2);
+    }
+
+    void receive(uint8_t c) {
+        if (kind == UBLOX || kind == UBLOX_NO_GST) {
+            if (ubx.encode(c) == UBX_OTHER && ubx.msgClass() == 0x06)
+                ublox();
+        } else if (kind == MTK || kind == MTK_FIXED_BAUD) {
+            if (c == '$') {
+                inLine = true;
+                lineLen = 0;
+            } else if (inLine && c == '\n') {
+                inLine = false;
+                line[lineLen] = 0;
+                mtk();
+            } else if (inLine && lineLen < sizeof(line) - 1) {
+                line[lineLen++] = (char)c;
+            }
+        }
+    }
+
+    void ublox() {
+        const uint8_t* p = ubx.payload();
+        static const uint8_t ids[8] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07, 0x08 };
+        int i;
+
+        switch (ubx.msgId()) {
+        case 0x01: //CFG-MSG, a receiver without GST refuses it
+            for (i = 0; i < 8; i++)
+                if (kind == UBLOX_NO_GST && ubx.length() == 3 && p[0] == 0xF0 && p[1] == 0x07) {
+                    ack(false, 0x06, 0x01);
+                    return;
+                }
+            for (i = 0; i < 8; i++)
+                if (ubx.length() == 3 && p[0] == 0xF0 && p[1] == ids[i]) {
+                    sentences = p[2] ? sentences | (1u << i) : sentences & ~(1u << i);
+                    ack(true, 0x06, 0x01);
+                    return;
+                }
+            ack(false, 0x06, 0x01);
+            break;
+        case 0x00: //CFG-PRT, acknowledged at the old rate, then switched
+            ack(true, 0x06, 0x00);
+            rxBaud = p[8] | p[9] << 8 | p[10] << 16 | p[11] << 24;
+            break;
+        case 0x08: //CFG-RATE
+            i = p[0] | p[1] << 8;
+            if (i < 50) {
+                ack(false, 0x06, 0x08);
+                break;
+            }
+            rateHz = 1000 / i;
+            ack(true, 0x06, 0x08);
+            break;
+        }
+    }
+
+    void mtk() {
+        static const int fields[8] = { 3, 0, 4, 5, 1, 2, -1, 17 };
+        char* star = strchr(line, '*');
+        unsigned char sum = 0;
+        unsigned cs;
+        int f[19], cmd, v, i;
+        char reply[32];
+
+        if (!star || sscanf(star + 1, "%2X", &cs) != 1)
+            return;
+        for (char* p = line; p < star; p++)
+            sum ^= (unsigned char)*p;
+        if (sum != cs || sscanf(line, "PMTK%d", &cmd) != 1)
+            return;
+
+        if (cmd == 314 && sscanf(line, "PMTK314,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
+                &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8], &f[9], &f[10], &f[11], &f[12],
+                &f[13], &f[14], &f[15], &f[16], &f[17], &f[18]) == 19) {
+            sentences = 0;
+            for (i = 0; i < 8; i++)
+                if (fields[i] >= 0 && f[fields[i]])
+                    sentences |= 1u << i;
+        } else if (cmd == 251 && sscanf(line, "PMTK251,%d", &v) == 1) {
+            if (kind == MTK)
+                rxBaud = v;
+            return;
+        } else if (cmd == 220 && sscanf(line, "PMTK220,%d", &v) == 1 && v >= 100) {
+            rateHz = 1000 / v;
+        } else {
+            return;
+        }
+        snprintf(reply, sizeof(reply), "PMTK001,%d,3", cmd);
+        send(sentence(reply));
+    }
+
+    std::deque<std::pair<uint8_t, int> > out;
+    UbxDecoder ubx;
+    char line[96];
+    size_t lineLen;
+    bool inLine;
+};
+
+static const char* const KIND_NAMES[] = { "u-blox", "u-blox without GST", "MTK", "MTK without baud change", "silent" };
+static const char* const RECEIVER_NAMES[] = { "unknown", "u-blox", "MTK" };
+
+//runs one scenario, expected is the outcome configure() should report.
+//A rate GpsConfig must refuse may not put a single byte on the link
+static bool scenario(Kind kind, int rateHz, bool expected, GpsReceiver expectedReceiver) {
+    SimReceiver rx(kind);
+    GpsConfig config(rx, 9600);
+    bool ok = config.configure(115200, rateHz);
+    bool validRate = rateHz > 0 && rateHz <= GpsConfig::MAX_RATE_HZ;
+    double load = (double)rx.burstBytes() * rx.rateHz / (rx.rxBaud / 10);
+    bool pass = ok == expected && config.receiver() == expectedReceiver && rx.hostBaud == rx.rxBaud &&
+        config.baud() == rx.rxBaud && (config.rate() == 0 || config.rate() == rx.rateHz) && load < 1 &&
+        (validRate || rx.clockMs == 0);
+
+    printf("%-24s %3d Hz: configure %s, receiver %s, link %d/%d baud, %d Hz, sentences 0x%02X, load %.0f%%, %lu ms: %s\n",
+        KIND_NAMES[kind], rateHz, ok ? "ok" : "failed", RECEIVER_NAMES[config.receiver()], config.baud(), rx.rxBaud,
+        rx.rateHz, rx.sentences, load * 100, rx.clockMs, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+int main() {
+    bool pass = true;
+    pass &= scenario(UBLOX, 10, true, GPS_RECEIVER_UBLOX);
+    pass &= scenario(UBLOX_NO_GST, 10, false, GPS_RECEIVER_UBLOX);
+    pass &= scenario(MTK, 10, true, GPS_RECEIVER_MTK);
+    pass &= scenario(MTK_FIXED_BAUD, 10, false, GPS_RECEIVER_MTK);
+    pass &= scenario(SILENT, 10, false, GPS_RECEIVER_UNKNOWN);
+    pass &= scenario(UBLOX, 0, false, GPS_RECEIVER_UNKNOWN);
+    pass &= scenario(UBLOX, -5, false, GPS_RECEIVER_UNKNOWN);
+    pass &= scenario(UBLOX, 25, false, GPS_RECEIVER_UNKNOWN);
+    return pass ? 0 : 1;
+}
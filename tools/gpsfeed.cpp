@@ -0,0 +1,100 @@
+// gpsfeed.cpp
+//host check of TinyGPS fed through a GpsTransport the way the DMA and interrupt transports deliver data
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -DGEOSOL_HOST -I../libraries/GpsLink -I../libraries/TinyGPS gpsfeed.cpp ../libraries/GpsLink/GpsTransport.cpp ../libraries/TinyGPS/TinyGPS.cpp -o gpsfeed
+//usage:
+//  gpsfeed recorded.nmea
+//
+//the log is replayed through BufferTransport in several batch shapes: DMA halves cut anywhere in a sentence,
+//batches ending at every line as the idle-line interrupt delivers them, and single characters.
+//each shape must give the same sentences, position, time and stats as feeding the log byte by byte
+
+#include "GpsTransport.h"
+#include "TinyGPS.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+using namespace GeoSol;
+
+//what a parser run ends with
+struct Outcome {
+    long sentences;
+    long lat, lon;
+    unsigned long date, time, chars;
+    unsigned short good, failed;
+};
+
+static Outcome finish(TinyGPS &gps, long sentences) {
+    Outcome o;
+    o.sentences = sentences;
+    gps.get_position(&o.lat, &o.lon);
+    gps.get_datetime(&o.date, &o.time);
+    gps.stats(&o.chars, &o.good, &o.failed);
+    return o;
+}
+
+static Outcome direct(const std::string &log) {
+    TinyGPS gps;
+    long sentences = 0;
+    for (size_t i = 0; i < log.size(); i++)
+        if (gps.encode(log[i]))
+            sentences++;
+    return finish(gps, sentences);
+}
+
+//same loop as main: read from the transport with a timeout, parse every batch at once
+static Outcome viaTransport(const std::string &log, size_t batch, bool lineBatches, unsigned long &batches) {
+    BufferTransport link((const uint8_t*)log.data(), log.size(), batch, lineBatches);
+    TinyGPS gps;
+    uint8_t buf[64];
+    size_t n;
+    long sentences = 0;
+
+    link.baud(115200);
+    while (!link.finished())
+        if ((n = link.read(buf, sizeof(buf), 100)) > 0)
+            sentences += gps.encode((const char*)buf, n);
+    batches = link.batches();
+    return finish(gps, sentences);
+}
+
+static bool same(const Outcome &a, const Outcome &b) {
+    return a.sentences == b.sentences && a.lat == b.lat && a.lon == b.lon && a.date == b.date &&
+        a.time == b.time && a.chars == b.chars && a.good == b.good && a.failed == b.failed;
+}
+
+int main(int argc, char** argv) {
+    std::string log;
+    char buf[4096];
+    size_t n;
+    FILE* f;
+    bool pass = true;
+    static const struct { const char* name; size_t batch; bool lines; } shapes[] = {
+        { "DMA halves of 512", 512, false },
+        { "DMA halves of 37", 37, false },
+        { "idle line, halves of 512", 512, true },
+        { "single characters", 1, false }
+    };
+
+    if (argc < 2 || !(f = fopen(argv[1], "rb"))) {
+        fprintf(stderr, "usage: gpsfeed recorded.nmea\n");
+        return 1;
+    }
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        log.append(buf, n);
+    fclose(f);
+
+    Outcome ref = direct(log);
+    printf("%lu bytes, %ld validated sentences, %u good, %u failed checksum\n",
+        (unsigned long)log.size(), ref.sentences, ref.good, ref.failed);
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        unsigned long batches;
+        Outcome o = viaTransport(log, shapes[i].batch, shapes[i].lines, batches);
+        bool ok = same(ref, o);
+        printf("%-26s %8lu reads: %s\n", shapes[i].name, batches, ok ? "PASS" : "FAIL");
+        pass &= ok;
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,396 @@
+// lcdtraffic.cpp
+//host check of the C12832 driver: counts SPI bytes of menu updates and checks the screen against the frame buffer
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -pthread -DGEOSOL_HOST -Imbedmock -I../libraries/C12832 lcdtraffic.cpp ../libraries/C12832/C12832.cpp ../libraries/C12832/GraphicsDisplay.cpp ../libraries/C12832/TextDisplay.cpp -o lcdtraffic
+//usage:
+//  lcdtraffic
+//
+//the mock SPI feeds an emulated controller RAM, which follows column and page address commands
+//like the real one. After every refresh the emulated screen must equal the frame buffer.
+//traffic of a menu update is compared with a full refresh of 4 pages, 3 commands and 128 data bytes each,
+//which the driver sent for every refresh before.
+//pin writes of a full refresh are compared with chip select and A0 set around every byte, as before.
+//a menu page drawn in one frame is compared with the same page refreshed after every character.
+//fills are compared with the pixel loops they replaced, on the frame buffer and in time.
+//finally the bus is slowed down and menu pages are drawn with and without the render thread,
+//the drawing side must not wait for the bus once the thread sends the frames, and commands and
+//invalidate() from the drawing side must not disturb what the thread sends
+
+#include "C12832.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+void (*SPI::sink)(int value) = 0;
+unsigned long DigitalOut::writes = 0;
+
+//frame buffer made visible
+class ProbeLcd : public C12832 {
+public:
+    ProbeLcd() : C12832(0, 0, 0, 0, 0) {}
+    const unsigned char* frame() const { return buffer; }
+    void load(const unsigned char* from) { memcpy(buffer, from, sizeof(buffer)); }
+};
+
+static ProbeLcd* lcd;
+
+//emulated controller
+static unsigned char ram[4][128];
+static int column, page;
+static unsigned long commands, data;
+
+static const unsigned long FULL_REFRESH = 4 * (3 + 128);
+
+//A0, chip select low and high for each of those bytes
+static const unsigned long FULL_REFRESH_PINS = FULL_REFRESH * 3;
+
+//time the emulated bus takes per byte
+static int spiNs;
+
+//the frame buffer holds still, every data byte must be selected and be what the buffer holds at its column
+static bool steady;
+static unsigned long glitches;
+
+//next command byte is the contrast value of a set contrast command
+static bool contrastValue;
+
+static void controller(int value) {
+    if (lcd == 0)
+        return;
+    if (spiNs) {
+        std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(spiNs);
+        while (std::chrono::steady_clock::now() < until)
+            ;
+    }
+    //the controller ignores the bus while it is not selected
+    if (lcd->_CS) {
+        glitches += steady;
+        return;
+    }
+    if (lcd->_A0) {
+        if (steady && (column >= 128 || value != lcd->frame()[page * 128 + column]))
+            glitches++;
+        if (column < 128)
+            ram[page][column++] = (unsigned char)value;
+        data++;
+        return;
+    }
+    commands++;
+    if (contrastValue)
+        contrastValue = false;
+    else if (value == 0x81)
+        contrastValue = true;
+    else if ((value & 0xF0) == 0x00)
+        column = (column & 0xF0) | (value & 0x0F);
+    else if ((value & 0xF0) == 0x10)
+        column = (column & 0x0F) | (value & 0x0F) << 4;
+    else if ((value & 0xF0) == 0xB0)
+        page = value & 0x03;
+}
+
+static bool screenMatches() {
+    return memcmp(ram, lcd->frame(), sizeof(ram)) == 0;
+}
+
+static unsigned long traffic() {
+    return commands + data;
+}
+
+//prints the three lines of a menu page the way printMenu() did
+static void drawMenu(const char* line1, const char* line2, const char* line3) {
+    lcd->cls();
+    lcd->locate(0, 0);
+    lcd->printf(line1);
+    lcd->locate(0, 10);
+    lcd->printf(line2);
+    lcd->locate(0, 20);
+    lcd->printf(line3);
+}
+
+//and the way it does now, in one frame
+static void drawMenuFrame(const char* line1, const char* line2, const char* line3) {
+    FrameGuard frame(*lcd);
+    drawMenu(line1, line2, line3);
+}
+
+//refreshes the driver sent for the same drawing before: one full refresh per cls and per character
+static unsigned long fullRefreshes(const char* line1, const char* line2, const char* line3) {
+    return (1 + strlen(line1) + strlen(line2) + strlen(line3)) * FULL_REFRESH;
+}
+
+//draws two menu pages in turn, returns the time spent drawing and handing over one page
+static double drawPages(int count) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        if (i % 2)
+            drawMenu("Direct geodetic problem", "Distance:", "1234.567 m");
+        else
+            drawMenu("Polar serif problem", "Point 2, current:", "48.117301, 11.516667");
+        lcd->copy_to_lcd();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / count;
+}
+
+//fillrect() as it was, one pixel at a time
+static void pixelRect(ProbeLcd &on, int x0, int y0, int x1, int y1, int colour) {
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+    for (int x = x0; x <= x1; x++)
+        for (int y = y0; y <= y1; y++)
+            on.pixel(x, y, colour);
+}
+
+//fillcircle() as it was, circles of growing radius
+static void circleFill(ProbeLcd &on, int x, int y, int r, int colour) {
+    for (int i = 0; i <= r; i++)
+        on.circle(x, y, i, colour);
+}
+
+static bool sameFrame(const ProbeLcd &a, const ProbeLcd &b) {
+    return memcmp(a.frame(), b.frame(), 512) == 0;
+}
+
+static bool lit(const ProbeLcd &on, int x, int y) {
+    return on.frame()[(y >> 3) * 128 + x] >> (y & 7) & 1;
+}
+
+//best of 5 runs, so that a busy host does not decide the comparison
+template <typename Draw>
+static double perCall(int count, Draw draw) {
+    double best = 1e9;
+    for (int run = 0; run < 5; run++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            draw(i);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / count);
+    }
+    return best;
+}
+
+static void waitRendered() {
+    while (lcd->rendering())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static int failures;
+
+//every check prints its verdict through here, so that any FAIL shows in the exit status
+static const char* verdict(bool pass) {
+    if (!pass)
+        failures++;
+    return pass ? "PASS" : "FAIL";
+}
+
+static void report(const char* name, unsigned long count, unsigned long before, double required,
+        const char* unit = "bytes") {
+    double ratio = count ? (double)before / count : before;
+    printf("%-36s %6lu %s, %7lu before, %6.1fx less: %s\n", name, count, unit, before, ratio,
+        verdict(screenMatches() && ratio >= required));
+}
+
+int main() {
+    const char* line1 = "Inverse geodetic problem";
+    const char* line2 = "Point 1, current:";
+    const char* line3a = "48.117300, 11.516667";
+    const char* line3b = "48.117301, 11.516667";
+    unsigned long start;
+
+    //drawn the old way, never sent
+    ProbeLcd reference;
+    reference.set_auto_up(0);
+
+    SPI::sink = controller;
+    lcd = new ProbeLcd();
+    //the constructor has cleared the screen before the sink could see the A0 pin
+    lcd->invalidate();
+    lcd->copy_to_lcd();
+
+    //auto update on and no frame, as the menu thread drew before: a refresh after every character
+    start = traffic();
+    drawMenu(line1, line2, line3a);
+    report("menu page, auto update", traffic() - start, fullRefreshes(line1, line2, line3a), 4);
+
+    start = traffic();
+    drawMenu(line1, line2, line3b);
+    report("one digit changed, auto update", traffic() - start, fullRefreshes(line1, line2, line3b), 4);
+
+    //the same two pages in frames, compared with a refresh after every character
+    unsigned long perCharacter = traffic() - start;
+    start = traffic();
+    drawMenuFrame(line1, line2, line3a);
+    report("one digit changed, frame", traffic() - start, perCharacter, 4);
+
+    //nested frames, drawing calls inside them send nothing until the outermost end_frame()
+    start = traffic();
+    lcd->begin_frame();
+    lcd->rect(2, 2, 40, 20, 1);
+    lcd->begin_frame();
+    lcd->fillcircle(90, 16, 8, 1);
+    lcd->end_frame();
+    bool held = traffic() == start;
+    lcd->end_frame();
+    bool nested = held && traffic() > start && screenMatches();
+    printf("%-36s %6lu bytes, sent once: %s\n", "nested frames", traffic() - start, verdict(nested));
+    drawMenuFrame(line1, line2, line3b);
+
+    //one refresh per frame
+    lcd->set_auto_up(0);
+    start = traffic();
+    drawMenu(line1, line2, line3a);
+    lcd->copy_to_lcd();
+    report("one digit changed, one refresh", traffic() - start, 2 * FULL_REFRESH, 4);
+
+    start = traffic();
+    drawMenu(line1, line2, line3a);
+    lcd->copy_to_lcd();
+    report("same text redrawn, one refresh", traffic() - start, 2 * FULL_REFRESH, 4);
+
+    //a whole screen, each page in one transaction
+    unsigned long pins = DigitalOut::writes;
+    start = traffic();
+    lcd->invalidate();
+    lcd->copy_to_lcd();
+    pins = DigitalOut::writes - pins;
+    report("full refresh", traffic() - start, FULL_REFRESH, 1);
+    report("full refresh", pins, FULL_REFRESH_PINS, 20, "pin writes");
+
+    //random drawing, the screen must follow the frame buffer through every partial refresh
+    srand(1);
+    int mismatches = 0, rounds = 2000;
+    for (int r = 0; r < rounds; r++) {
+        int x0 = rand() % 140 - 6, y0 = rand() % 40 - 4, x1 = rand() % 140 - 6, y1 = rand() % 40 - 4;
+        int colour = rand() % 2;
+        lcd->setmode(rand() % 4 == 0 ? XOR : NORMAL);
+        switch (rand() % 7) {
+        case 0: lcd->pixel(x0, y0, colour); break;
+        case 1: lcd->line(x0, y0, x1, y1, colour); break;
+        case 2: lcd->rect(x0, y0, x1, y1, colour); break;
+        case 3: lcd->fillrect(x0, y0, x1, y1, colour); break;
+        case 4: lcd->circle(x0, y0, rand() % 12, colour); break;
+        case 5: lcd->locate(x0, y0); lcd->printf("%d", rand()); break;
+        case 6: if (rand() % 20 == 0) lcd->cls(); break;
+        }
+        if (rand() % 3 == 0) {
+            lcd->copy_to_lcd();
+            mismatches += !screenMatches();
+        }
+    }
+    lcd->copy_to_lcd();
+    mismatches += !screenMatches();
+    printf("%-36s %6d rounds, %d mismatches: %s\n", "random drawing", rounds, mismatches,
+        verdict(mismatches == 0));
+
+    //fills against pixel loops on the same random screen, in both modes and colours
+    unsigned char noise[512];
+    int differ = 0, outside = 0, missed = 0;
+    for (int r = 0; r < rounds; r++) {
+        int x0 = rand() % 140 - 6, y0 = rand() % 40 - 4, x1 = rand() % 140 - 6, y1 = rand() % 40 - 4;
+        int colour = rand() % 2, mode = rand() % 2 ? XOR : NORMAL;
+        for (int i = 0; i < 512; i++)
+            noise[i] = (unsigned char)rand();
+        lcd->load(noise);
+        reference.load(noise);
+        lcd->setmode(mode);
+        reference.setmode(mode);
+        switch (rand() % 3) {
+        case 0:
+            lcd->fillrect(x0, y0, x1, y1, colour);
+            pixelRect(reference, x0, y0, x1, y1, colour);
+            break;
+        case 1:
+            lcd->line(x0, y0, x0, y1, colour);
+            pixelRect(reference, x0, y0, x0, y1, colour);
+            break;
+        case 2:
+            lcd->line(x0, y0, x1, y0, colour);
+            pixelRect(reference, x0, y0, x1, y0, colour);
+            break;
+        }
+        differ += !sameFrame(*lcd, reference);
+
+        //the circles left holes, so the new fill has to cover them and the outline, and stay inside the outline
+        int rad = rand() % 20;
+        memset(noise, 0, sizeof(noise));
+        lcd->load(noise);
+        reference.load(noise);
+        lcd->setmode(NORMAL);
+        reference.setmode(NORMAL);
+        lcd->fillcircle(x0, y0, rad, 1);
+        circleFill(reference, x0, y0, rad, 1);
+        reference.circle(x0, y0, rad, 1);
+        for (int x = 0; x < 128; x++)
+            for (int y = 0; y < 32; y++) {
+                missed += lit(reference, x, y) && !lit(*lcd, x, y);
+                outside += lit(*lcd, x, y) && (x - x0) * (x - x0) + (y - y0) * (y - y0) > rad * rad + rad;
+            }
+    }
+    lcd->setmode(NORMAL);
+    lcd->invalidate();
+    lcd->copy_to_lcd();
+    printf("%-36s %6d rounds, %d differ from pixel loops, %d circle pixels missed, %d outside: %s\n",
+        "fills", rounds, differ, missed, outside, verdict(differ == 0 && missed == 0 && outside == 0 && screenMatches()));
+
+    //time on the frame buffer alone, nothing is sent
+    double rectNew = perCall(20000, [](int i) { lcd->fillrect(0, 0, 127, 31, i & 1); });
+    double rectOld = perCall(2000, [&](int i) { pixelRect(reference, 0, 0, 127, 31, i & 1); });
+    double circleNew = perCall(20000, [](int i) { lcd->fillcircle(64, 16, 15, i & 1); });
+    double circleOld = perCall(2000, [&](int i) { circleFill(reference, 64, 16, 15, i & 1); });
+    lcd->copy_to_lcd();
+    printf("%-36s %6.2f us per full screen fillrect, %.2f us before, %.1fx: %s\n", "fill speed", rectNew * 1e6,
+        rectOld * 1e6, rectOld / rectNew, verdict(rectOld >= 10 * rectNew));
+    printf("%-36s %6.2f us per fillcircle r=15, %.2f us before, %.1fx: %s\n", "", circleNew * 1e6,
+        circleOld * 1e6, circleOld / circleNew, verdict(circleOld >= 10 * circleNew));
+
+    //a bus of 2 us per byte, then the same pages handed to the render thread
+    spiNs = 2000;
+    double direct = drawPages(40);
+    lcd->start_render_thread();
+    double threaded = drawPages(40);
+    waitRendered();
+    bool rendered = screenMatches() && threaded * 4 < direct;
+    printf("%-36s %6.0f us per page drawn, %.0f us sending directly: %s\n", "render thread", threaded * 1e6,
+        direct * 1e6, verdict(rendered));
+
+    //random drawing through the render thread, checked whenever it has caught up
+    spiNs = 0;
+    mismatches = 0;
+    for (int r = 0; r < rounds; r++) {
+        lcd->begin_frame();
+        lcd->fillrect(rand() % 128, rand() % 32, rand() % 128, rand() % 32, rand() % 2);
+        lcd->locate(rand() % 128, rand() % 32);
+        lcd->printf("%d", rand());
+        lcd->end_frame();
+        lcd->copy_to_lcd();
+        if (rand() % 10 == 0) {
+            waitRendered();
+            mismatches += !screenMatches();
+        }
+    }
+    waitRendered();
+    mismatches += !screenMatches();
+    printf("%-36s %6d rounds, %d mismatches: %s\n", "random drawing, render thread", rounds, mismatches,
+        verdict(mismatches == 0));
+
+    //a still picture sent whole again and again while the drawing thread sets contrast and inversion:
+    //a command falling between the address and data bytes of the thread, or data sent from a copy
+    //of the screen that invalidate() changed under it, puts a wrong byte on the screen
+    spiNs = 200;
+    steady = true;
+    for (int r = 0; r < 300; r++) {
+        lcd->invalidate();
+        lcd->copy_to_lcd();
+        //wake up again while the thread is sending
+        std::this_thread::sleep_for(std::chrono::microseconds(rand() % 200));
+        lcd->set_contrast(rand() % 64);
+        lcd->invert(0);
+    }
+    waitRendered();
+    steady = false;
+    printf("%-36s %6d rounds, %lu wrong bytes sent: %s\n", "invalidate and commands, render thread", 300,
+        glitches, verdict(glitches == 0 && screenMatches()));
+    return failures ? 1 : 0;
+}
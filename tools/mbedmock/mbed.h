@@ -0,0 +1,75 @@
+// mbed.h
+//just enough of the mbed API to build display drivers on the host,
+//SPI writes go to a callback that the tool defines and sets
+
+#ifndef MBED_MOCK_H
+#define MBED_MOCK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+typedef int PinName;
+static const PinName NC = -1;
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin, int value = 0) : _value(value) { (void)pin; }
+    DigitalOut& operator=(int value) {
+        _value = value;
+        writes++;
+        return *this;
+    }
+    operator int() const { return _value; }
+
+    //number of pin writes of all DigitalOut objects, defined by the tool
+    static unsigned long writes;
+private:
+    int _value;
+};
+
+class SPI {
+public:
+    SPI(PinName mosi, PinName miso, PinName sclk) { (void)mosi; (void)miso; (void)sclk; }
+    void format(int bits, int mode = 0) { (void)bits; (void)mode; }
+    void frequency(int hz) { (void)hz; }
+    int write(int value) {
+        if (sink)
+            sink(value);
+        return 0;
+    }
+
+    //receives every byte written by any SPI object, defined by the tool
+    static void (*sink)(int value);
+};
+
+class Stream {
+public:
+    Stream(const char* name = NULL) { (void)name; }
+    virtual ~Stream() {}
+    int putc(int c) { return _putc(c); }
+    int puts(const char* s) {
+        while (*s)
+            _putc(*s++);
+        return 0;
+    }
+    int printf(const char* format, ...) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        puts(buf);
+        return n;
+    }
+protected:
+    virtual int _putc(int c) = 0;
+    virtual int _getc() = 0;
+};
+
+inline void wait(float s) { (void)s; }
+inline void wait_ms(int ms) { (void)ms; }
+inline void wait_us(int us) { (void)us; }
+
+#endif
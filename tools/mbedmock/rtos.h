@@ -0,0 +1,66 @@
+// rtos.h
+//the parts of mbed-rtos used by the drivers, on std::thread
+
+#ifndef RTOS_MOCK_H
+#define RTOS_MOCK_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+enum osPriority { osPriorityIdle = -3, osPriorityLow = -2, osPriorityBelowNormal = -1, osPriorityNormal = 0,
+    osPriorityAboveNormal = 1, osPriorityHigh = 2, osPriorityRealtime = 3 };
+enum osStatus { osOK = 0 };
+static const uint32_t osWaitForever = 0xFFFFFFFF;
+
+//runs detached, priorities are ignored
+class Thread {
+public:
+    Thread(void (*task)(void const* argument), void* argument = NULL, osPriority priority = osPriorityNormal) {
+        (void)priority;
+        std::thread(task, argument).detach();
+    }
+    static void wait(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+};
+
+class Semaphore {
+public:
+    Semaphore(int32_t count) : _count(count) {}
+    int32_t wait(uint32_t millisec = osWaitForever) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (millisec == osWaitForever)
+            _cv.wait(lock, [this] { return _count > 0; });
+        else if (!_cv.wait_for(lock, std::chrono::milliseconds(millisec), [this] { return _count > 0; }))
+            return 0;
+        return _count--;
+    }
+    osStatus release(void) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _count++;
+        _cv.notify_one();
+        return osOK;
+    }
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    int32_t _count;
+};
+
+class Mutex {
+public:
+    osStatus lock(uint32_t millisec = osWaitForever) {
+        (void)millisec;
+        _mutex.lock();
+        return osOK;
+    }
+    bool trylock() { return _mutex.try_lock(); }
+    osStatus unlock() {
+        _mutex.unlock();
+        return osOK;
+    }
+private:
+    std::mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,137 @@
+// nmeabench.cpp
+//host benchmark of TinyGPS parsing: per-character encode(char) against chunked encode(buf, len)
+//
+//build on the host:
+//  g++ -O2 -DGEOSOL_HOST -I../libraries/TinyGPS nmeabench.cpp ../libraries/TinyGPS/TinyGPS.cpp -o nmeabench
+//usage:
+//  nmeabench [recorded NMEA log]
+//
+//without a log a synthetic one is generated with the default output set of common receivers:
+//RMC, VTG, GGA, GSA, three GSV and GLL once per fix.
+//both paths must report the same number of validated sentences and the same last position
+
+#include "TinyGPS.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+//size of chunks handed to encode(buf, len), like one UART read
+static const size_t CHUNK = 64;
+
+static const int ROUNDS = 20;
+
+//append sentence body with $ and checksum
+static void addSentence(std::string &log, const char* body) {
+    char tail[8];
+    unsigned char sum = 0;
+    for (const char* p = body; *p; p++)
+        sum ^= (unsigned char)*p;
+    snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+    log += '$';
+    log += body;
+    log += tail;
+}
+
+static std::string synthesize(size_t bytes) {
+    std::string log;
+    char body[120];
+    int i = 0;
+
+    while (log.size() < bytes) {
+        int s = i % 3600, lat = 4807 + i % 50, lon = 1131 + i % 70;
+        snprintf(body, sizeof(body), "GPRMC,%02d%02d%02d.00,A,%04d.%05d,N,%05d.%05d,E,0.022,,230394,,,A",
+            s / 3600, s / 60 % 60, s % 60, lat, i % 100000, lon, (i * 7) % 100000);
+        addSentence(log, body);
+        addSentence(log, "GPVTG,,T,,M,0.022,N,0.041,K,A");
+        snprintf(body, sizeof(body), "GPGGA,%02d%02d%02d.00,%04d.%05d,N,%05d.%05d,E,1,08,0.9,545.4,M,46.9,M,,",
+            s / 3600, s / 60 % 60, s % 60, lat, i % 100000, lon, (i * 7) % 100000);
+        addSentence(log, body);
+        addSentence(log, "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1");
+        addSentence(log, "GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00");
+        addSentence(log, "GPGSV,3,2,11,14,25,170,00,16,57,208,39,18,67,296,40,19,40,246,00");
+        addSentence(log, "GPGSV,3,3,11,22,42,067,42,24,14,311,43,27,05,244,00");
+        snprintf(body, sizeof(body), "GPGLL,%04d.%05d,N,%05d.%05d,E,%02d%02d%02d.00,A,A",
+            lat, i % 100000, lon, (i * 7) % 100000, s / 3600, s / 60 % 60, s % 60);
+        addSentence(log, body);
+        i++;
+    }
+    return log;
+}
+
+static bool load(const char* path, std::string &log) {
+    FILE* f = fopen(path, "rb");
+    char buf[4096];
+    size_t n;
+    if (!f)
+        return false;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        log.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+//result of one pass over the log
+struct Pass {
+    double seconds;
+    long sentences;
+    long lat, lon;
+};
+
+static Pass perCharacter(const std::string &log) {
+    Pass res = {0, 0, 0, 0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        TinyGPS gps;
+        res.sentences = 0;
+        for (size_t i = 0; i < log.size(); i++)
+            if (gps.encode(log[i]))
+                res.sentences++;
+        gps.get_position(&res.lat, &res.lon);
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+    return res;
+}
+
+static Pass chunked(const std::string &log) {
+    Pass res = {0, 0, 0, 0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        TinyGPS gps;
+        res.sentences = 0;
+        for (size_t i = 0; i < log.size(); i += CHUNK)
+            res.sentences += gps.encode(log.data() + i, log.size() - i < CHUNK ? log.size() - i : CHUNK);
+        gps.get_position(&res.lat, &res.lon);
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+    return res;
+}
+
+int main(int argc, char** argv) {
+    std::string log;
+    Pass a, b;
+
+    if (argc > 1) {
+        if (!load(argv[1], log)) {
+            fprintf(stderr, "cannot read %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        log = synthesize(1 << 20);
+    }
+
+    a = perCharacter(log);
+    b = chunked(log);
+    printf("log: %lu bytes, %ld validated sentences\n", (unsigned long)log.size(), a.sentences);
+    printf("encode(char):      %8.2f MB/s\n", log.size() / a.seconds / 1e6);
+    printf("encode(buf, %3lu):  %8.2f MB/s\n", (unsigned long)CHUNK, log.size() / b.seconds / 1e6);
+    printf("speedup:           %8.2f\n", a.seconds / b.seconds);
+
+    if (a.sentences != b.sentences || a.lat != b.lat || a.lon != b.lon) {
+        printf("MISMATCH: %ld/%ld sentences, position %ld %ld / %ld %ld\n",
+            a.sentences, b.sentences, a.lat, a.lon, b.lat, b.lon);
+        return 1;
+    }
+    return 0;
+}
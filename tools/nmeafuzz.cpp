@@ -0,0 +1,213 @@
+// nmeafuzz.cpp
+//fuzz target of TinyGPS::encode: malformed input must not corrupt memory, and parsing it character by character
+//must end in the same state as parsing it in chunks
+//
+//build on the host with libFuzzer:
+//  clang++ -std=c++11 -g -O1 -fsanitize=fuzzer,address,undefined -DNMEAFUZZ_LIBFUZZER -DGEOSOL_HOST -I../libraries/TinyGPS nmeafuzz.cpp ../libraries/TinyGPS/TinyGPS.cpp -o nmeafuzz
+//  nmeafuzz corpus/
+//or with the built-in mutator, where only g++ is around:
+//  g++ -std=c++11 -g -O1 -fsanitize=address,undefined -DGEOSOL_HOST -I../libraries/TinyGPS nmeafuzz.cpp ../libraries/TinyGPS/TinyGPS.cpp -o nmeafuzz
+//  nmeafuzz [iterations] [recorded.nmea or -] [seed]
+//
+//the built-in mutator cuts, repeats and garbles sentences of the log, or of a few built-in ones for -, and stores
+//an input breaking the comparison in nmeafuzz-crash.nmea. Before that, inputs of bugs found so far have to
+//leave the expected date and time
+
+#include "TinyGPS.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+//public state of the parser after an input
+struct State {
+    long lat, lon;
+    int32_t latHr, lonHr;
+    unsigned long date, time, speed, course, hdop, satCount, pdop, vdop, rms, latErr, lonErr, altErr, chars;
+    long altitude;
+    unsigned int fixMode, activeCount, inView;
+    unsigned char active[12];
+    unsigned short good, failed;
+    int sentences;
+    bool ready[8];
+};
+
+static void capture(TinyGPS &gps, int sentences, State &s) {
+    memset(&s, 0, sizeof(s));
+    gps.get_position(&s.lat, &s.lon);
+    gps.get_position_hr(&s.latHr, &s.lonHr);
+    gps.get_datetime(&s.date, &s.time);
+    s.speed = gps.speed();
+    s.course = gps.course();
+    s.hdop = gps.hdop();
+    s.satCount = gps.sat_count();
+    s.pdop = gps.pdop();
+    s.vdop = gps.vdop();
+    s.rms = gps.range_rms();
+    gps.get_errors(&s.latErr, &s.lonErr, &s.altErr);
+    s.altitude = gps.altitude();
+    s.fixMode = gps.fix_mode();
+    s.activeCount = gps.active_sat_count();
+    if (s.activeCount > sizeof(s.active))
+        abort();
+    memcpy(s.active, gps.active_sats(), s.activeCount);
+    s.inView = gps.sats_in_view();
+    gps.stats(&s.chars, &s.good, &s.failed);
+    s.sentences = sentences;
+    s.ready[0] = gps.rmc_ready();
+    s.ready[1] = gps.gga_ready();
+    s.ready[2] = gps.gsv_ready();
+    s.ready[3] = gps.gsa_ready();
+    s.ready[4] = gps.gst_ready();
+    s.ready[5] = gps.vtg_ready();
+    s.ready[6] = gps.gll_ready();
+    s.ready[7] = gps.zda_ready();
+}
+
+//runs one input both ways, the first byte picks the chunk size; returns false when the states differ
+static bool check(const uint8_t* data, size_t size) {
+    TinyGPS single, chunked;
+    State a, b;
+    int sa = 0, sb = 0;
+    size_t chunk = size ? data[0] % 67 + 1 : 1, i, n;
+
+    for (i = 0; i < size; i++)
+        sa += single.encode((char)data[i]);
+    for (i = 0; i < size; i += n) {
+        n = size - i < chunk ? size - i : chunk;
+        sb += chunked.encode((const char*)data + i, n);
+    }
+    capture(single, sa, a);
+    capture(chunked, sb, b);
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+#ifdef NMEAFUZZ_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (!check(data, size))
+        abort();
+    return 0;
+}
+
+#else
+
+//seeds when no log is given: every sentence type parsed, with empty fields and long terms
+static const char* const SEEDS =
+    "$GPRMC,123519.00,A,4807.038123,N,01131.000456,E,0.022,,230394,,,A*77\r\n"
+    "$GNGGA,123519.00,4807.03800,N,01131.00000,E,1,08,0.9,545.4,M,46.9,M,,*77\r\n"
+    "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n"
+    "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74\r\n"
+    "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*25\r\n"
+    "$GPGST,123519.00,0.006,0.023,0.020,273.6,0.023,0.020,0.031*5E\r\n"
+    "$GLGLL,4807.03800,S,01131.00000,W,123519.00,A,A*75\r\n"
+    "$GPZDA,123519.00,23,03,1994,00,00*6C\r\n"
+    "$GPZDA,123519.00,,04,1994,00,00*6A\r\n"
+    "$PUBX,00,123519.00,4807.03800,N*6C\r\n";
+
+//inputs which once committed a wrong state, with the date and time they have to leave
+struct Case {
+    const char* input;
+    unsigned long date, time;
+};
+
+static const Case CASES[] = {
+    //a ZDA without day must not combine the day of the previous one with its month and year
+    {"$GPZDA,123519.00,23,03,1994,00,00*6C\r\n$GPZDA,201530.00,,04,1994,00,00*62\r\n", 230394, 12351900},
+    {"$GPZDA,123519.00,23,03,1994,00,00*6C\r\n$GPZDA,201530.00,,,,00,00*63\r\n", 230394, 12351900},
+    //nor a ZDA which ends after the day
+    {"$GPZDA,123519.00,23,03,1994,00,00*6C\r\n$GPZDA,201530.00,05*66\r\n", 230394, 12351900},
+};
+
+//returns the number of cases leaving another date or time
+static int checkCases() {
+    int failed = 0;
+    for (size_t c = 0; c < sizeof(CASES) / sizeof(CASES[0]); c++) {
+        TinyGPS gps;
+        unsigned long date, time;
+        gps.encode(CASES[c].input, strlen(CASES[c].input));
+        gps.get_datetime(&date, &time);
+        if (date != CASES[c].date || time != CASES[c].time) {
+            printf("case %lu: date %06lu time %08lu, expected %06lu %08lu\n", (unsigned long)c, date, time,
+                CASES[c].date, CASES[c].time);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+static uint32_t rng = 2463534242u;
+
+static uint32_t next() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+//characters most likely to change the parser state
+static char interesting() {
+    static const char chars[] = ",,,,**$$\r\n0123456789.-ANSWEVPG\xFF\x80";
+    return chars[next() % (sizeof(chars) - 1)];
+}
+
+static std::string mutate(const std::string &seed) {
+    size_t start = next() % seed.size(), len = next() % 400 + 1;
+    std::string s = seed.substr(start, len);
+    int edits = next() % 8 + 1;
+
+    for (int e = 0; e < edits && !s.empty(); e++) {
+        size_t at = next() % s.size();
+        switch (next() % 6) {
+        case 0: s[at] = (char)next(); break;
+        case 1: s[at] = interesting(); break;
+        case 2: s.insert(at, 1, interesting()); break;
+        case 3: s.erase(at, next() % 8 + 1); break;
+        case 4: s.insert(at, std::string(next() % 40 + 1, (char)('0' + next() % 10))); break;
+        case 5: s.insert(at, s.substr(at, next() % 80)); break;
+        }
+    }
+    //random chunk size
+    s.insert(s.begin(), (char)next());
+    return s;
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000, i;
+    std::string seed(SEEDS), input;
+    FILE* f;
+
+    if (argc > 2 && strcmp(argv[2], "-") != 0) {
+        char buf[4096];
+        size_t n;
+        if (!(f = fopen(argv[2], "rb"))) {
+            fprintf(stderr, "usage: nmeafuzz [iterations] [recorded.nmea or -] [seed]\n");
+            return 1;
+        }
+        seed.clear();
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            seed.append(buf, n);
+        fclose(f);
+    }
+    if (argc > 3)
+        rng = (uint32_t)strtoul(argv[3], 0, 10) | 1;
+
+    if (checkCases())
+        return 1;
+    for (i = 0; i < iterations; i++) {
+        input = mutate(seed);
+        if (!check((const uint8_t*)input.data(), input.size())) {
+            f = fopen("nmeafuzz-crash.nmea", "wb");
+            if (f) {
+                fwrite(input.data(), 1, input.size(), f);
+                fclose(f);
+            }
+            printf("input %ld: parsing per character and in chunks differ, saved to nmeafuzz-crash.nmea\n", i);
+            return 1;
+        }
+    }
+    printf("%ld inputs: PASS\n", iterations);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,98 @@
+// nmeareplay.cpp
+//host tool to stream a recorded NMEA log through TinyGPS and print the decoded fixes
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -DGEOSOL_HOST -I../libraries/TinyGPS nmeareplay.cpp ../libraries/TinyGPS/TinyGPS.cpp -o nmeareplay
+//usage:
+//  nmeareplay recorded.nmea [chunk size] > fixes.csv
+//
+//every sentence carrying a fix (RMC, GGA, GLL) adds a CSV line with the state of the parser after it,
+//the satellite and dilution columns come from the last GGA, GSA and GSV seen.
+//sentence counts, checksum failures and the parsing rate, measured without printing, go to stderr
+
+#include "TinyGPS.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+//chunk handed to encode(buf, len) unless given, like one UART read
+static const size_t CHUNK = 64;
+
+//passes timed for the rate
+static const int ROUNDS = 10;
+
+static bool load(const char* path, std::string &log) {
+    FILE* f = fopen(path, "rb");
+    char buf[4096];
+    size_t n;
+    if (!f)
+        return false;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        log.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+static void printFix(TinyGPS &gps) {
+    int32_t lat, lon;
+    unsigned long date, time, age;
+    gps.get_position_hr(&lat, &lon, &age);
+    gps.get_datetime(&date, &time);
+    printf("%06lu,%08lu,%.7f,%.7f,%.2f,%.2f,%.2f,%lu,%u,%u,%.2f,%.2f,%.2f\n",
+        date, time, lat * 1e-7, lon * 1e-7, gps.f_altitude(), gps.f_speed_knots(), gps.f_course(),
+        gps.sat_count(), gps.active_sat_count(), gps.sats_in_view(), gps.f_hdop(), gps.pdop() / 100.0,
+        gps.vdop() / 100.0);
+}
+
+int main(int argc, char** argv) {
+    std::string log;
+    size_t chunk, i, len;
+    unsigned long chars;
+    unsigned short good, failed;
+    long fixes = 0, sentences = 0;
+
+    if (argc < 2 || !load(argv[1], log)) {
+        fprintf(stderr, "usage: nmeareplay recorded.nmea [chunk size]\n");
+        return 1;
+    }
+    chunk = argc > 2 ? strtoul(argv[2], 0, 10) : CHUNK;
+    if (chunk == 0)
+        chunk = 1;
+
+    //fix time series, one sentence at a time so that no fix is missed within a chunk
+    TinyGPS gps;
+    printf("date,time,lat_deg,lon_deg,alt_m,speed_kn,course_deg,sats_used,sats_active,sats_in_view,hdop,pdop,vdop\n");
+    for (i = 0; i < log.size(); i += chunk) {
+        const char* p = log.data() + i;
+        const char* end = p + (log.size() - i < chunk ? log.size() - i : chunk);
+        const char* start = p;
+        //hand the chunk over up to each line end, a fix completes at most once per line
+        for (; p < end; p++)
+            if (*p == '\n' || p + 1 == end) {
+                if (gps.encode(start, p + 1 - start) > 0) {
+                    printFix(gps);
+                    fixes++;
+                }
+                start = p + 1;
+            }
+    }
+    gps.stats(&chars, &good, &failed);
+
+    //rate of whole chunks as the firmware parses them
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        TinyGPS timed;
+        for (i = 0; i < log.size(); i += chunk) {
+            len = log.size() - i < chunk ? log.size() - i : chunk;
+            sentences += timed.encode(log.data() + i, len);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / ROUNDS;
+
+    fprintf(stderr, "%lu bytes: %ld fixes, %u sentences passed checksum, %u failed checksum\n",
+        chars, fixes, good, failed);
+    fprintf(stderr, "%.3f ms per pass in chunks of %lu: %.0f fix sentences/s, %.1f MB/s\n",
+        seconds * 1e3, (unsigned long)chunk, sentences / ROUNDS / seconds, log.size() / seconds / 1e6);
+    return 0;
+}
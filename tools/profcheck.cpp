@@ -0,0 +1,123 @@
+// profcheck.cpp
+//host check of Profiler: statistics, histogram bins, dump() output and PROFILE_SCOPE timing
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -DGEOSOL_HOST -DGEOSOL_PROFILE -I../libraries/Profiler profcheck.cpp ../libraries/Profiler/Profiler.cpp -o profcheck
+//usage:
+//  profcheck
+//
+//known durations are recorded and must come back as count, min, max, mean and bins, also in the text of dump().
+//a scope which spins for a known time must record about that time once, nested scopes on their own probes.
+//every check prints PASS or FAIL, the exit status is 1 when any failed
+
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+using namespace GeoSol;
+
+static int failures;
+
+static void check(const char* name, bool pass) {
+    printf("%-40s %s\n", name, pass ? "PASS" : "FAIL");
+    if (!pass)
+        failures++;
+}
+
+//one duration per bin edge: zero, 1, both ends of 2..3, a middle bin and the top of the last one
+static const uint32_t DURATIONS[] = {0, 1, 2, 3, 1000, 0xFFFFFFFFUL};
+static const int DURATION_COUNT = sizeof(DURATIONS) / sizeof(DURATIONS[0]);
+
+static std::string dumped;
+
+static void collect(const char* line) {
+    dumped += line;
+}
+
+//busy wait, so that the scope measures running time and not a sleep of uncertain length
+static void spin(int us) {
+    std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < until)
+        ;
+}
+
+static void outer() {
+    PROFILE_SCOPE(PROBE_DIRECT);
+    spin(2000);
+    {
+        PROFILE_SCOPE(PROBE_POLAR);
+        spin(1000);
+    }
+}
+
+int main() {
+    Profiler::init();
+
+    //statistics of known durations
+    uint64_t sum = 0;
+    for (int i = 0; i < DURATION_COUNT; i++) {
+        Profiler::record(PROBE_INVERSE, DURATIONS[i]);
+        sum += DURATIONS[i];
+    }
+    const ProfileStats &st = Profiler::stats(PROBE_INVERSE);
+    check("count, min, max and sum", st.count == DURATION_COUNT && st.min == 0 && st.max == 0xFFFFFFFFUL && st.sum == sum);
+
+    uint32_t expected[PROFILE_BINS];
+    memset(expected, 0, sizeof(expected));
+    expected[0] = 1;    //0
+    expected[1] = 1;    //1
+    expected[2] = 2;    //2, 3
+    expected[10] = 1;   //1000 has 10 significant bits
+    expected[32] = 1;   //0xFFFFFFFF
+    check("histogram bins", memcmp(st.hist, expected, sizeof(expected)) == 0);
+
+    bool others = true;
+    for (int p = 0; p < PROBE_COUNT; p++)
+        others &= p == PROBE_INVERSE || Profiler::stats(p).count == 0;
+    check("other probes untouched", others);
+
+    //min starts from the first sample, not from zero
+    Profiler::record(PROBE_GPS_ENCODE, 500);
+    Profiler::record(PROBE_GPS_ENCODE, 700);
+    check("min of first sample", Profiler::stats(PROBE_GPS_ENCODE).min == 500 && Profiler::stats(PROBE_GPS_ENCODE).max == 700);
+
+    //dump() prints probes with samples only, mean and bins labelled with their longest duration
+    char line[80];
+    std::string want = "probe count min max mean\r\n";
+    snprintf(line, sizeof(line), "GeoFuncs::inverse %d 0 4294967295 %lu\r\n", DURATION_COUNT,
+        (unsigned long)(sum / DURATION_COUNT));
+    want += line;
+    want += "  <=0 1\r\n  <=1 1\r\n  <=3 2\r\n  <=1023 1\r\n  <=4294967295 1\r\n";
+    want += "TinyGPS::encode 2 500 700 600\r\n  <=511 1\r\n  <=1023 1\r\n";
+    Profiler::dump(collect);
+    check("dump text", dumped == want);
+    if (dumped != want)
+        printf("got:\n%swanted:\n%s", dumped.c_str(), want.c_str());
+
+    bool named = true;
+    for (int p = 0; p < PROBE_COUNT; p++)
+        for (int q = 0; q < p; q++)
+            named &= Profiler::name(p) != 0 && strcmp(Profiler::name(p), Profiler::name(q)) != 0;
+    check("probe names distinct", named);
+
+    Profiler::reset();
+    bool cleared = true;
+    for (int p = 0; p < PROBE_COUNT; p++)
+        cleared &= Profiler::stats(p).count == 0 && Profiler::stats(p).sum == 0 && Profiler::stats(p).hist[0] == 0;
+    dumped.clear();
+    Profiler::dump(collect);
+    check("reset", cleared && dumped == "probe count min max mean\r\n");
+
+    //scopes record their own lifetime in nanoseconds on the host, a busy host only makes them longer
+    outer();
+    const ProfileStats &direct = Profiler::stats(PROBE_DIRECT), &polar = Profiler::stats(PROBE_POLAR);
+    printf("%-40s %lu us, inner %lu us\n", "scope of 3 ms with inner scope of 1 ms", (unsigned long)(direct.max / 1000),
+        (unsigned long)(polar.max / 1000));
+    check("PROFILE_SCOPE records once per scope", direct.count == 1 && polar.count == 1);
+    check("PROFILE_SCOPE duration", direct.max >= 3000000 && direct.max < 100000000 &&
+        polar.max >= 1000000 && polar.max < direct.max);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+// ringstress.cpp
+//host stress test of SpscRing: a producer thread plays the UART receive interrupt, the main thread drains in chunks
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -pthread -DGEOSOL_HOST -I../libraries/GpsLink ringstress.cpp -o ringstress
+//usage:
+//  ringstress [megabytes per run]
+//
+//the producer pushes bursts of up to 16 bytes, as many as a UART FIFO holds, paced to a given byte rate,
+//and records every byte refused by a full ring. The consumer sometimes stalls to mimic a display update
+//holding the core.
+//a run passes when the consumer received exactly the produced bytes minus the refused ones, in order
+
+#include "SpscRing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace GeoSol;
+
+//byte carried by sequence number i, not periodic in 256 so that shifts are caught
+static uint8_t value(uint32_t i) {
+    return (uint8_t)((i * 2654435761u) >> 24);
+}
+
+template <uint32_t N>
+static bool run(const char* name, uint32_t total, double mbps, int stallEvery) {
+    static SpscRing<N> ring;
+    std::vector<uint32_t> refused;
+    std::vector<uint8_t> received;
+    volatile bool done = false;
+    uint8_t chunk[64];
+    size_t n, i, k = 0;
+    uint32_t reads = 0;
+    bool pass;
+
+    received.reserve(total);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        uint32_t seq = 0, burst, j;
+        unsigned rnd = 1;
+        while (seq < total) {
+            //wait for the time the UART would have received this byte
+            while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * mbps * 1e6 < seq)
+                std::this_thread::yield();
+            rnd = rnd * 1103515245u + 12345u;
+            burst = 1 + (rnd >> 16) % 16;
+            for (j = 0; j < burst && seq < total; j++, seq++)
+                if (!ring.put(value(seq)))
+                    refused.push_back(seq);
+        }
+        done = true;
+    });
+
+    for (;;) {
+        bool finished = done;
+        n = ring.get(chunk, sizeof(chunk));
+        received.insert(received.end(), chunk, chunk + n);
+        if (n == 0 && finished)
+            break;
+        if (n == 0)
+            std::this_thread::yield();
+        if (stallEvery && ++reads % stallEvery == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    //expected stream is every sequence number except the refused ones
+    pass = received.size() + refused.size() == total;
+    for (i = 0, n = 0; pass && i < total; i++) {
+        if (k < refused.size() && refused[k] == i) {
+            k++;
+            continue;
+        }
+        pass = received[n++] == value((uint32_t)i);
+    }
+
+    printf("%-30s %10lu bytes, %8lu refused, %6.1f MB/s: %s\n", name, (unsigned long)received.size(),
+        (unsigned long)refused.size(), total / seconds / 1e6, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    uint32_t total = (uint32_t)((argc > 1 ? atof(argv[1]) : 64) * 1e6);
+    bool pass = true;
+
+    pass &= run<1024>("1024-byte ring", total, 20, 0);
+    pass &= run<1024>("1024-byte ring, stalls", total, 20, 1000);
+    pass &= run<16>("16-byte ring", total, 20, 0);
+    pass &= run<16>("16-byte ring, stalls", total, 20, 100);
+    pass &= run<1024>("1024-byte ring, unpaced", total, 1e6, 0);
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+// ubxdump.cpp
+//host tool to decode captured u-blox UBX streams with UbxDecoder
+//
+//build on the host:
+//  g++ -std=c++11 -O2 -I../libraries/UbxDecoder ubxdump.cpp ../libraries/UbxDecoder/UbxDecoder.cpp -o ubxdump
+//usage:
+//  ubxdump capture.ubx [chunk size] > fixes.csv
+//  ubxdump -
+//
+//NAV-PVT and NAV-HPPOSLLH solutions are printed as CSV lines, counts of frames go to stderr.
+//the capture is fed in chunks like UART reads, 64 bytes unless given, so the bulk path is exercised.
+//with - a built-in stream of damaged frames between good ones is decoded at several chunk sizes instead,
+//every good frame has to come out
+
+#include "UbxDecoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace GeoSol;
+
+static bool load(const char* path, std::string &data) {
+    FILE* f = fopen(path, "rb");
+    char buf[4096];
+    size_t n;
+    if (!f)
+        return false;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+static void printPvt(const UbxNavPvt &pvt) {
+    printf("PVT,%lu,%04u-%02u-%02uT%02u:%02u:%02u,%u,%u,%.7f,%.7f,%.3f,%.3f,%.3f,%.2f\n",
+        (unsigned long)pvt.iTOW, pvt.year, pvt.month, pvt.day, pvt.hour, pvt.min, pvt.sec,
+        pvt.fixType, pvt.numSV, pvt.lat * 1e-7, pvt.lon * 1e-7, pvt.height * 1e-3,
+        pvt.hAcc * 1e-3, pvt.gSpeed * 1e-3, pvt.pDOP * 0.01);
+}
+
+static void printHpposllh(const UbxNavHpposllh &pos) {
+    printf("HPPOSLLH,%lu,,%u,,%.9f,%.9f,%.4f,%.4f,,\n",
+        (unsigned long)pos.iTOW, pos.flags & 1 ? 0 : 1, UbxDecoder::latNano(pos) * 1e-9, UbxDecoder::lonNano(pos) * 1e-9,
+        pos.height * 1e-3 + pos.heightHp * 1e-4, pos.hAcc * 1e-4);
+}
+
+static void appendFrame(std::string &data, uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+    std::string frame;
+    uint8_t a = 0, b = 0;
+    frame += (char)cls;
+    frame += (char)id;
+    frame += (char)(len & 0xFF);
+    frame += (char)(len >> 8);
+    frame.append((const char*)payload, len);
+    for (size_t i = 0; i < frame.size(); i++) {
+        a += (uint8_t)frame[i];
+        b += a;
+    }
+    data += "\xB5\x62";
+    data += frame;
+    data += (char)a;
+    data += (char)b;
+}
+
+//damaged frames between good ones, with the number of good ones and of lengths to reject
+static std::string damagedStream(unsigned long* good, unsigned long* rejected) {
+    std::string data;
+    uint8_t payload[UbxDecoder::MAX_PAYLOAD];
+    UbxNavPvt pvt;
+    UbxNavHpposllh hp;
+
+    memset(&pvt, 0, sizeof(pvt));
+    memset(&hp, 0, sizeof(hp));
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 7);
+    *good = *rejected = 0;
+    for (int round = 0; round < 3; round++) {
+        pvt.iTOW = hp.iTOW = 1000 * round;
+        data += "$GPGGA,,,,,,0,00,,,,,,,*66\r\n";
+        //corrupted lengths, the good frames right after them must still be found
+        data += std::string("\xB5\x62\x01\x07\xFF\xFF", 6);
+        appendFrame(data, 0x01, 0x07, (const uint8_t*)&pvt, sizeof(pvt));
+        data += std::string("\xB5\x62\x01\x14\x65\x00", 6);
+        appendFrame(data, 0x01, 0x14, (const uint8_t*)&hp, sizeof(hp));
+        //a longest frame is kept, one byte more is rejected and its payload, without sync chars, skipped
+        appendFrame(data, 0x0A, 0x04, payload, UbxDecoder::MAX_PAYLOAD);
+        appendFrame(data, 0x0A, 0x04, payload, UbxDecoder::MAX_PAYLOAD + 1);
+        *good += 3;
+        *rejected += 3;
+    }
+    //and an acknowledgement right after the last one
+    appendFrame(data, 0x05, 0x01, payload, 2);
+    *good += 1;
+    return data;
+}
+
+//decodes the damaged stream in chunks, returns true when every good frame came out
+static bool checkDamaged(size_t chunk) {
+    unsigned long good, rejected, frames, failed, dropped, pvt = 0, hp = 0;
+    std::string data = damagedStream(&good, &rejected);
+    UbxDecoder ubx;
+    UbxMessage msg;
+
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        const uint8_t* p = (const uint8_t*)data.data() + i;
+        size_t len = data.size() - i < chunk ? data.size() - i : chunk, used;
+        while (len > 0) {
+            used = ubx.encode(p, len, msg);
+            p += used;
+            len -= used;
+            pvt += msg == UBX_NAV_PVT;
+            hp += msg == UBX_NAV_HPPOSLLH;
+        }
+    }
+    ubx.stats(&frames, &failed, &dropped);
+    bool pass = frames == good && pvt == 3 && hp == 3 && dropped == rejected && failed == 0;
+    printf("chunks of %4lu: %lu of %lu frames, %lu lengths rejected, %lu failed checksum: %s\n",
+        (unsigned long)chunk, frames, good, dropped, failed, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    std::string data;
+    UbxDecoder ubx;
+    UbxMessage msg;
+    size_t chunk, i, len, used;
+    unsigned long pvt = 0, hp = 0, frames, failed, dropped;
+
+    if (argc > 1 && strcmp(argv[1], "-") == 0) {
+        static const size_t chunks[] = {1, 7, 64, 100000};
+        bool pass = true;
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+            pass &= checkDamaged(chunks[c]);
+        return pass ? 0 : 1;
+    }
+    if (argc < 2 || !load(argv[1], data)) {
+        fprintf(stderr, "usage: ubxdump capture.ubx [chunk size]\n       ubxdump -\n");
+        return 1;
+    }
+    chunk = argc > 2 ? strtoul(argv[2], 0, 10) : 64;
+    if (chunk == 0)
+        chunk = 1;
+
+    printf("message,itow_ms,utc,fix,satellites,lat_deg,lon_deg,height_m,hacc_m,speed_mps,pdop\n");
+    for (i = 0; i < data.size(); i += chunk) {
+        const uint8_t* p = (const uint8_t*)data.data() + i;
+        len = data.size() - i < chunk ? data.size() - i : chunk;
+        //a chunk may hold several frames, each one is handled before the next overwrites it
+        while (len > 0) {
+            used = ubx.encode(p, len, msg);
+            p += used;
+            len -= used;
+            if (msg == UBX_NAV_PVT) {
+                printPvt(ubx.navPvt());
+                pvt++;
+            } else if (msg == UBX_NAV_HPPOSLLH) {
+                printHpposllh(ubx.navHpposllh());
+                hp++;
+            }
+        }
+    }
+
+    ubx.stats(&frames, &failed, &dropped);
+    fprintf(stderr, "%lu bytes: %lu frames (%lu NAV-PVT, %lu NAV-HPPOSLLH), %lu failed checksum, %lu too long\n",
+        (unsigned long)data.size(), frames, pvt, hp, failed, dropped);
+    return 0;
+}